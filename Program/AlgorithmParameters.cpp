@@ -25,6 +25,17 @@ struct AlgorithmParameters default_algorithm_parameters() {
 	ap.nbIterTraces = 500;
 	ap.timeLimit = 0;
 	ap.useSwapStar = 1;
+	ap.maxMovesLS = 0;
+	ap.timeLimitLS = 0;
+	ap.nbThreadsLS = 1;
+	ap.nbIterDecomposition = 0;
+	ap.sizeDecomposition = 300;
+	ap.timeLimitDecomposition = 5;
+	ap.nbCoarseningLevels = 0;
+	ap.nbRecentGiantTours = 0;
+	ap.routeCacheSize = 0;
+	ap.printStatistics = 0;
+	ap.traceSize = 0;
 
 	return ap;
 }
@@ -46,5 +57,16 @@ void print_algorithm_parameters(const AlgorithmParameters & ap)
 	std::cout << "---- nbIterTraces            is set to " << ap.nbIterTraces << std::endl;
 	std::cout << "---- timeLimit               is set to " << ap.timeLimit << std::endl;
 	std::cout << "---- useSwapStar             is set to " << ap.useSwapStar << std::endl;
+	std::cout << "---- maxMovesLS              is set to " << ap.maxMovesLS << std::endl;
+	std::cout << "---- timeLimitLS             is set to " << ap.timeLimitLS << std::endl;
+	std::cout << "---- nbThreadsLS             is set to " << ap.nbThreadsLS << std::endl;
+	std::cout << "---- nbIterDecomposition     is set to " << ap.nbIterDecomposition << std::endl;
+	std::cout << "---- sizeDecomposition       is set to " << ap.sizeDecomposition << std::endl;
+	std::cout << "---- timeLimitDecomposition  is set to " << ap.timeLimitDecomposition << std::endl;
+	std::cout << "---- nbCoarseningLevels      is set to " << ap.nbCoarseningLevels << std::endl;
+	std::cout << "---- nbRecentGiantTours      is set to " << ap.nbRecentGiantTours << std::endl;
+	std::cout << "---- routeCacheSize          is set to " << ap.routeCacheSize << std::endl;
+	std::cout << "---- printStatistics         is set to " << ap.printStatistics << std::endl;
+	std::cout << "---- traceSize               is set to " << ap.traceSize << std::endl;
 	std::cout << "==================================================" << std::endl;
 }
@@ -24,6 +24,17 @@ struct AlgorithmParameters {
 	int nbIterTraces;       // Number of iterations between traces display during HGS execution
 	double timeLimit;		// CPU time limit until termination in seconds. Default value: 0 (i.e., inactive)
 	int useSwapStar;		// Use SWAP* local search or not. Default value: 1. Only available when coordinates are provided.
+	int maxMovesLS;			// Maximum number of moves applied by one call of the local search before it is interrupted and resumed later. Default value: 0 (i.e., inactive)
+	double timeLimitLS;		// CPU time limit of one call of the local search in seconds, after which it is interrupted and resumed later. Default value: 0 (i.e., inactive)
+	int nbThreadsLS;		// Number of threads of the local search. If larger than 1, groups of neighboring routes are first improved in parallel before the sequential search. Default value: 1
+	int nbIterDecomposition;	// Number of iterations between decomposition phases, in which subproblems made of neighboring routes of the best solution are solved in parallel. Default value: 0 (i.e., inactive)
+	int sizeDecomposition;		// Target number of customers of each subproblem of the decomposition phases. Default value: 300
+	double timeLimitDecomposition;	// CPU time limit in seconds for solving each subproblem of a decomposition phase. Default value: 5
+	int nbRecentGiantTours;	// Number of giant tours of recent offspring memorized, to skip the Split and local search of an offspring duplicating one of them. Default value: 0 (i.e., inactive)
+	int nbCoarseningLevels;	// Number of coarsening levels of the multilevel mode, in which pairs of close customers are merged, the coarsest instance is solved by HGS and its solution is refined by local search at each finer level. Default value: 0 (i.e., inactive)
+	int routeCacheSize;		// Number of entries of the cache of route evaluations (distance, load and duration), indexed by a hash of the sequence of customers. Default value: 0 (i.e., inactive)
+	int printStatistics;	// Prints the counters and times of the phases of the algorithm with the traces, and exports them in JSON format with the solution (executable only). Default value: 0 (i.e., inactive)
+	int traceSize;			// Number of events kept per thread to export a timeline of the phases of the algorithm in Chrome trace format (executable only). Default value: 0 (i.e., inactive)
 };
 
 #ifdef __cplusplus
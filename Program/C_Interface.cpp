@@ -16,6 +16,7 @@ Solution *prepare_solution(Population &population, Params &params)
 	// Preparing the best solution
 	Solution *sol = new Solution;
 	sol->time = (double)(clock() - params.startTime) / (double)CLOCKS_PER_SEC;
+	sol->stats = population.getStatistics();
 
 	if (population.getBestFound() != nullptr) {
 		// Best individual
@@ -27,15 +28,15 @@ Solution *prepare_solution(Population &population, Params &params)
 		// finding out the number of routes in the best individual
 		int n_routes = 0;
 		for (int k = 0; k < params.nbVehicles; k++)
-			if (!best->chromR[k].empty()) ++n_routes;
+			if (!best->route(k).empty()) ++n_routes;
 
 		// filling out the route information
 		sol->n_routes = n_routes;
 		sol->routes = new SolutionRoute[n_routes];
 		for (int k = 0; k < n_routes; k++) {
-			sol->routes[k].length = (int)best->chromR[k].size();
+			sol->routes[k].length = best->route(k).size();
 			sol->routes[k].path = new int[sol->routes[k].length];
-			std::copy(best->chromR[k].begin(), best->chromR[k].end(), sol->routes[k].path);
+			std::copy(best->route(k).begin(), best->route(k).end(), sol->routes[k].path);
 		}
 	}
 	else {
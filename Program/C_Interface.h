@@ -5,6 +5,7 @@
 #ifndef C_INTERFACE_H
 #define C_INTERFACE_H
 #include "AlgorithmParameters.h"
+#include "Statistics.h"
 
 struct SolutionRoute
 {
@@ -18,6 +19,7 @@ struct Solution
 	double time;
 	int n_routes;
 	struct SolutionRoute * routes;
+	struct Statistics stats;	// Counters and times of the phases of the algorithm
 };
 
 #ifdef __cplusplus
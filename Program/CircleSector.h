@@ -1,6 +1,9 @@
 #ifndef CIRCLESECTOR_H
 #define CIRCLESECTOR_H
 
+#include <vector>
+#include <algorithm>
+
 // Simple data structure to represent circle sectors
 // Angles are measured in [0,65535] instead of [0,359], in such a way that modulo operations are much faster (since 2^16 = 65536)
 // Credit to Fabian Giesen at "https://web.archive.org/web/20200912191950/https://fgiesen.wordpress.com/2015/09/24/intervals-in-modular-arithmetic/" for useful implementation tips regarding interval overlaps in modular arithmetics 
@@ -51,4 +54,90 @@ struct CircleSector
 	}
 };
 
+// Index of a set of circle sectors, kept ordered by increasing start angle
+// Allows to enumerate the sectors overlapping a given one without testing all pairs of sectors
+struct CircleSectorIndex
+{
+	std::vector<CircleSector> sectors;	// Sector associated to each element
+	std::vector<int> position;			// Position of each element in the ordered list (-1 if the element is not indexed)
+	std::vector<int> order;				// Indexed elements ordered by increasing start angle
+	int maxLength;						// Upper bound on the length of the indexed sectors
+
+	// Initializes an empty index for elements in {0,...,nbElements-1}
+	void initialize(int nbElements)
+	{
+		sectors = std::vector<CircleSector>(nbElements);
+		position = std::vector<int>(nbElements, -1);
+		order.clear();
+		maxLength = 0;
+	}
+
+	// Inserts an element or updates its sector
+	// The ordered list is repaired by moving the element, which is fast as sectors usually change by small amounts
+	void update(int element, const CircleSector & sector)
+	{
+		sectors[element] = sector;
+		maxLength = std::max<int>(maxLength, CircleSector::positive_mod(sector.end - sector.start));
+		int pos = position[element];
+		if (pos == -1)
+		{
+			pos = (int)order.size();
+			order.push_back(element);
+		}
+		while (pos > 0 && sectors[order[pos - 1]].start > sector.start)
+		{
+			order[pos] = order[pos - 1];
+			position[order[pos]] = pos;
+			pos--;
+		}
+		while (pos < (int)order.size() - 1 && sectors[order[pos + 1]].start < sector.start)
+		{
+			order[pos] = order[pos + 1];
+			position[order[pos]] = pos;
+			pos++;
+		}
+		order[pos] = element;
+		position[element] = pos;
+	}
+
+	// Removes an element from the index (if present)
+	void remove(int element)
+	{
+		if (position[element] == -1) return;
+		for (int pos = position[element]; pos < (int)order.size() - 1; pos++)
+		{
+			order[pos] = order[pos + 1];
+			position[order[pos]] = pos;
+		}
+		order.pop_back();
+		position[element] = -1;
+	}
+
+	// Recomputes the exact maximum length (the bound is otherwise only increased when sectors change)
+	void refreshMaxLength()
+	{
+		maxLength = 0;
+		for (int element : order)
+			maxLength = std::max<int>(maxLength, CircleSector::positive_mod(sectors[element].end - sectors[element].start));
+	}
+
+	// Fills "overlapping" with the indexed elements whose sectors overlap the given sector
+	// A sector S2 overlapping S1 either starts in S1, or starts at most maxLength units before the start of S1
+	void getOverlaps(const CircleSector & sector, std::vector<int> & overlapping)
+	{
+		overlapping.clear();
+		if (order.empty()) return;
+		int windowStart = CircleSector::positive_mod(sector.start - maxLength);
+		int windowLength = CircleSector::positive_mod(sector.end - sector.start) + maxLength;
+		int first = (int)(std::lower_bound(order.begin(), order.end(), windowStart,
+			[this](int element, int angle) { return sectors[element].start < angle; }) - order.begin());
+		for (int k = 0; k < (int)order.size(); k++)
+		{
+			int element = order[(first + k) % (int)order.size()];
+			if (windowLength < 65536 && CircleSector::positive_mod(sectors[element].start - windowStart) > windowLength) break;
+			if (CircleSector::overlap(sector, sectors[element])) overlapping.push_back(element);
+		}
+	}
+};
+
 #endif
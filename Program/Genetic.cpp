@@ -1,7 +1,25 @@
 #include "Genetic.h"
+#include <thread>
+
+// Subproblem of a decomposition phase, made of the customers of some routes of the best solution
+struct SubProblem
+{
+	std::vector <int> clients;						// Original indices of the nodes of the subproblem (clients[0] is the depot)
+	std::vector <double> x_coords;					// Data of the nodes of the subproblem
+	std::vector <double> y_coords;
+	std::vector < std::vector <double> > dist_mtx;
+	std::vector <double> service_time;
+	std::vector <double> demands;
+	int nbVehicles;									// Number of vehicles available for the subproblem
+	double distance;								// Distance of the routes of the subproblem in the best solution
+	std::vector < std::vector <int> > routes;		// Routes of the best solution of the subproblem (with original indices), if it improves the original routes
+};
 
 void Genetic::run()
 {	
+	/* MULTILEVEL MODE */
+	if (params.ap.nbCoarseningLevels > 0 && solveCoarseInstance()) return;
+
 	/* INITIAL POPULATION */
 	population.generatePopulation();
 
@@ -10,22 +28,32 @@ void Genetic::run()
 	if (params.verbose) std::cout << "----- STARTING GENETIC ALGORITHM" << std::endl;
 	for (nbIter = 0 ; nbIterNonProd <= params.ap.nbIter && (params.ap.timeLimit == 0 || (double)(clock()-params.startTime)/(double)CLOCKS_PER_SEC < params.ap.timeLimit) ; nbIter++)
 	{	
+		TraceScope traceScope(params.traceBuffers[0], "iteration");
+		params.stats.nbIterations++;
+
 		/* SELECTION AND CROSSOVER */
-		crossoverOX(offspring, population.getBinaryTournament(),population.getBinaryTournament());
+		bool isNewOffspring = crossoverOX(offspring, population.getBinaryTournament(),population.getBinaryTournament());
 
-		/* LOCAL SEARCH */
-		localSearch.run(offspring, params.penaltyCapacity, params.penaltyDuration);
-		bool isNewBest = population.addIndividual(offspring,true);
-		if (!offspring.eval.isFeasible && params.ran()%2 == 0) // Repair half of the solutions in case of infeasibility
+		/* LOCAL SEARCH (SKIPPED FOR AN OFFSPRING DUPLICATING A RECENT ONE) */
+		bool isNewBest = false;
+		if (isNewOffspring)
 		{
-			localSearch.run(offspring, params.penaltyCapacity*10., params.penaltyDuration*10.);
-			if (offspring.eval.isFeasible) isNewBest = (population.addIndividual(offspring,false) || isNewBest);
+			if (!localSearch.run(offspring, params.penaltyCapacity, params.penaltyDuration)) localSearch.resume(offspring); // An interrupted search is resumed as long as the time limit allows it
+			isNewBest = population.addIndividual(offspring,true);
+			if (!offspring.eval.isFeasible && params.ran()%2 == 0) // Repair half of the solutions in case of infeasibility
+			{
+				if (!localSearch.repair(offspring, params.penaltyCapacity*10., params.penaltyDuration*10.)) localSearch.resume(offspring);
+				if (offspring.eval.isFeasible) isNewBest = (population.addIndividual(offspring,false) || isNewBest);
+			}
 		}
 
 		/* TRACKING THE NUMBER OF ITERATIONS SINCE LAST SOLUTION IMPROVEMENT */
 		if (isNewBest) nbIterNonProd = 1;
 		else nbIterNonProd ++ ;
 
+		/* DECOMPOSITION OF LARGE INSTANCES */
+		if (params.ap.nbIterDecomposition > 0 && nbIter > 0 && nbIter % params.ap.nbIterDecomposition == 0 && decompose()) nbIterNonProd = 1;
+
 		/* DIVERSIFICATION, PENALTY MANAGEMENT AND TRACES */
 		if (nbIter % params.ap.nbIterPenaltyManagement == 0) population.managePenalties();
 		if (nbIter % params.ap.nbIterTraces == 0) population.printState(nbIter, nbIterNonProd);
@@ -40,41 +68,291 @@ void Genetic::run()
 	if (params.verbose) std::cout << "----- GENETIC ALGORITHM FINISHED AFTER " << nbIter << " ITERATIONS. TIME SPENT: " << (double)(clock() - params.startTime) / (double)CLOCKS_PER_SEC << std::endl;
 }
 
-void Genetic::crossoverOX(Individual & result, const Individual & parent1, const Individual & parent2)
+bool Genetic::decompose()
+{
+	TraceScope traceScope(params.traceBuffers[0], "decompose");
+	const Individual * bestSolution = population.getBestFeasible();
+	if (bestSolution == NULL || !params.areCoordinatesProvided) return false;
+
+	// Ordering the routes by polar angle of their barycenter around the depot, and grouping consecutive routes
+	std::vector < std::pair <double, int> > routePolarAngles;
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		if (bestSolution->route(r).empty()) continue;
+		double sumX = 0.;
+		double sumY = 0.;
+		for (int i : bestSolution->route(r))
+		{
+			sumX += params.cli[i].coordX;
+			sumY += params.cli[i].coordY;
+		}
+		double nbCustomers = (double)bestSolution->route(r).size();
+		routePolarAngles.push_back(std::pair <double, int>(atan2(sumY / nbCustomers - params.cli[0].coordY, sumX / nbCustomers - params.cli[0].coordX), r));
+	}
+	std::sort(routePolarAngles.begin(), routePolarAngles.end());
+	std::vector < std::vector <int> > routeGroups(1);
+	int nbCustomersGroup = 0;
+	for (std::pair <double, int> & myPair : routePolarAngles)
+	{
+		if (nbCustomersGroup >= params.ap.sizeDecomposition)
+		{
+			routeGroups.push_back(std::vector <int>());
+			nbCustomersGroup = 0;
+		}
+		routeGroups.back().push_back(myPair.second);
+		nbCustomersGroup += bestSolution->route(myPair.second).size();
+	}
+	if (routeGroups.size() >= 2 && 2 * nbCustomersGroup < params.ap.sizeDecomposition) // A small last group is merged with the previous one
+	{
+		routeGroups[routeGroups.size() - 2].insert(routeGroups[routeGroups.size() - 2].end(), routeGroups.back().begin(), routeGroups.back().end());
+		routeGroups.pop_back();
+	}
+	if (routeGroups.size() < 2) return false; // The subproblem would be the complete instance
+
+	// Building the subproblems. The unused vehicles are shared between them, so that the merged solution respects the fleet size
+	int nbGroups = (int)routeGroups.size();
+	std::vector < SubProblem > subProblems(nbGroups);
+	for (int g = 0; g < nbGroups; g++)
+	{
+		SubProblem & subProblem = subProblems[g];
+		subProblem.clients.push_back(0);
+		subProblem.distance = 0.;
+		for (int r : routeGroups[g])
+		{
+			subProblem.clients.insert(subProblem.clients.end(), bestSolution->route(r).begin(), bestSolution->route(r).end());
+			int previousClient = 0;
+			for (int i : bestSolution->route(r))
+			{
+				subProblem.distance += params.timeCost[previousClient][i];
+				previousClient = i;
+			}
+			subProblem.distance += params.timeCost[previousClient][0];
+		}
+		for (int i : subProblem.clients)
+		{
+			subProblem.x_coords.push_back(params.cli[i].coordX);
+			subProblem.y_coords.push_back(params.cli[i].coordY);
+			subProblem.service_time.push_back(params.cli[i].serviceDuration);
+			subProblem.demands.push_back(params.cli[i].demand);
+			subProblem.dist_mtx.push_back(std::vector <double>());
+			for (int j : subProblem.clients) subProblem.dist_mtx.back().push_back(params.timeCost[i][j]);
+		}
+		subProblem.nbVehicles = (int)routeGroups[g].size() + (params.nbVehicles - bestSolution->eval.nbRoutes) / nbGroups;
+	}
+
+	// Solving the subproblems in parallel. All subproblems share the CPU clock of the process, hence the time limit of each one is scaled by the number of subproblems
+	AlgorithmParameters subAp = params.ap;
+	subAp.nbIterDecomposition = 0;
+	subAp.nbThreadsLS = 1;
+	subAp.traceSize = 0; // The phases of the subproblems are not traced, only the decomposition phase as a whole
+	subAp.timeLimit = params.ap.timeLimitDecomposition * nbGroups;
+	if (params.ap.timeLimit > 0) subAp.timeLimit = std::min<double>(subAp.timeLimit, params.ap.timeLimit - (double)(clock() - params.startTime) / (double)CLOCKS_PER_SEC);
+	if (subAp.timeLimit <= 0) return false;
+	std::vector < std::thread > threads;
+	for (SubProblem & subProblem : subProblems)
+	{
+		subAp.seed = (int)params.ran();
+		threads.push_back(std::thread([&subProblem, subAp, this]()
+		{
+			if (subProblem.clients.size() < 3) return; // Not enough customers to apply the crossover
+			try
+			{
+				Params subParams(subProblem.x_coords, subProblem.y_coords, subProblem.dist_mtx, subProblem.service_time, subProblem.demands,
+					params.vehicleCapacity, params.durationLimit, subProblem.nbVehicles, params.isDurationConstraint, false, subAp);
+				Genetic subSolver(subParams);
+				subSolver.run();
+				const Individual * subBest = subSolver.population.getBestFeasible();
+				if (subBest == NULL || subBest->eval.distance > subProblem.distance - MY_EPSILON) return;
+				for (int r = 0; r < subParams.nbVehicles; r++)
+				{
+					RouteSequence subRoute = subBest->route(r);
+					if (subRoute.empty()) continue;
+					subProblem.routes.push_back(std::vector <int>());
+					for (int i : subRoute) subProblem.routes.back().push_back(subProblem.clients[i]);
+				}
+			}
+			catch (const std::string &)
+			{
+				// An exception escaping the thread would terminate the program: a subproblem which cannot be solved (e.g., rejected by the safeguards of Params) is simply not improved
+				subProblem.routes.clear();
+			}
+		}));
+	}
+	for (std::thread & myThread : threads) myThread.join();
+
+	// Merging the improved routes with the other routes of the best solution
+	Individual merged(params);
+	int nbImprovedGroups = 0;
+	int nbRoutes = 0;
+	int pos = 0;
+	for (int g = 0; g < nbGroups; g++)
+	{
+		if (!subProblems[g].routes.empty()) nbImprovedGroups++;
+		else for (int r : routeGroups[g]) subProblems[g].routes.push_back(std::vector <int>(bestSolution->route(r).begin(), bestSolution->route(r).end()));
+		for (std::vector <int> & route : subProblems[g].routes)
+		{
+			merged.routeStarts[nbRoutes++] = pos;
+			for (int i : route) merged.chromT[pos++] = i;
+		}
+	}
+	for (int r = nbRoutes; r <= params.nbVehicles; r++) merged.routeStarts[r] = pos;
+	if (params.verbose) std::cout << "----- DECOMPOSITION: " << nbImprovedGroups << " OF " << nbGroups << " SUBPROBLEMS IMPROVED" << std::endl;
+	if (nbImprovedGroups == 0) return false;
+	merged.evaluateCompleteCost(params);
+
+	// The local search on the merged solution also optimizes across the boundaries of the subproblems
+	if (!localSearch.run(merged, params.penaltyCapacity, params.penaltyDuration)) localSearch.resume(merged);
+	return population.addIndividual(merged, false);
+}
+
+bool Genetic::solveCoarseInstance()
 {
-	// Frequency table to track the customers which have been already inserted
-	std::vector <bool> freqClient = std::vector <bool> (params.nbClients + 1, false);
+	TraceScope traceScope(params.traceBuffers[0], "solveCoarseInstance");
+
+	// Matching each customer, in random order, with its closest unmatched correlated customer such that the pair fits in one route
+	// The pair becomes a node of the coarse instance, always visited in the order of the cheapest direction
+	std::vector <int> orderClients;
+	for (int i = 1; i <= params.nbClients; i++) orderClients.push_back(i);
+	std::shuffle(orderClients.begin(), orderClients.end(), params.ran);
+	std::vector <bool> isMatched(params.nbClients + 1, false);
+	std::vector < std::pair <int, int> > coarseNodes = { {0, 0} }; // First and last customer of each node of the coarse instance (the depot first)
+	for (int i : orderClients)
+	{
+		if (isMatched[i]) continue;
+		isMatched[i] = true;
+		int bestMatch = -1;
+		for (int j : params.correlatedVertices[i])
+		{
+			if (isMatched[j] || params.cli[i].demand + params.cli[j].demand > params.vehicleCapacity) continue;
+			if (params.isDurationConstraint && params.timeCost[0][i] + params.cli[i].serviceDuration + params.timeCost[i][j] + params.cli[j].serviceDuration + params.timeCost[j][0] > params.durationLimit) continue;
+			if (bestMatch == -1 || std::min<double>(params.timeCost[i][j], params.timeCost[j][i]) < std::min<double>(params.timeCost[i][bestMatch], params.timeCost[bestMatch][i])) bestMatch = j;
+		}
+		if (bestMatch == -1) coarseNodes.push_back({ i, i });
+		else
+		{
+			isMatched[bestMatch] = true;
+			if (params.timeCost[i][bestMatch] <= params.timeCost[bestMatch][i]) coarseNodes.push_back({ i, bestMatch });
+			else coarseNodes.push_back({ bestMatch, i });
+		}
+	}
+	int nbCoarseNodes = (int)coarseNodes.size();
+	if (nbCoarseNodes - 1 == params.nbClients) return false;
+	if (params.verbose) std::cout << "----- COARSENING: " << params.nbClients << " CUSTOMERS MERGED INTO " << nbCoarseNodes - 1 << " NODES" << std::endl;
 
-	// Picking the beginning and end of the crossover zone
-	std::uniform_int_distribution<> distr(0, params.nbClients-1);
-	int start = distr(params.ran);
-	int end = distr(params.ran);
+	// Data of the coarse instance: a node is entered by its first customer and left by its last one, and the distance between them is part of its service duration
+	std::vector <double> x_coords, y_coords, service_time, demands;
+	std::vector < std::vector <double> > dist_mtx(nbCoarseNodes, std::vector <double>(nbCoarseNodes, 0.));
+	for (int k = 0; k < nbCoarseNodes; k++)
+	{
+		int first = coarseNodes[k].first;
+		int last = coarseNodes[k].second;
+		if (params.areCoordinatesProvided)
+		{
+			x_coords.push_back(0.5 * (params.cli[first].coordX + params.cli[last].coordX));
+			y_coords.push_back(0.5 * (params.cli[first].coordY + params.cli[last].coordY));
+		}
+		service_time.push_back(params.cli[first].serviceDuration + ((first != last) ? params.timeCost[first][last] + params.cli[last].serviceDuration : 0.));
+		demands.push_back(params.cli[first].demand + ((first != last) ? params.cli[last].demand : 0.));
+		for (int l = 0; l < nbCoarseNodes; l++)
+			if (l != k) dist_mtx[k][l] = params.timeCost[last][coarseNodes[l].first];
+	}
 
-	// Avoid that start and end coincide by accident
-	while (end == start) end = distr(params.ran);
+	// Solving the coarse instance, keeping part of the remaining time for the refinements
+	AlgorithmParameters coarseAp = params.ap;
+	coarseAp.nbCoarseningLevels = params.ap.nbCoarseningLevels - 1;
+	coarseAp.seed = (int)params.ran();
+	coarseAp.traceSize = 0; // The phases of the coarse instance are not traced, only its solution as a whole
+	if (params.ap.timeLimit > 0) coarseAp.timeLimit = std::max<double>(0.01, 0.9 * (params.ap.timeLimit - (double)(clock() - params.startTime) / (double)CLOCKS_PER_SEC));
+	Params coarseParams(x_coords, y_coords, dist_mtx, service_time, demands, params.vehicleCapacity, params.durationLimit, params.nbVehicles, params.isDurationConstraint, params.verbose, coarseAp);
+	Genetic coarseSolver(coarseParams);
+	coarseSolver.run();
+	const Individual * coarseSolution = coarseSolver.population.getBestFound();
+	if (coarseSolution == NULL) return false;
 
-	// Copy from start to end
-	int j = start;
-	while (j % params.nbClients != (end + 1) % params.nbClients)
+	// Projecting the coarse solution on this instance, and refining it with the penalties reached on the coarse instance
+	Individual solution(params);
+	int pos = 0;
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		solution.routeStarts[r] = pos;
+		for (int k : coarseSolution->route(r))
+		{
+			solution.chromT[pos++] = coarseNodes[k].first;
+			if (coarseNodes[k].second != coarseNodes[k].first) solution.chromT[pos++] = coarseNodes[k].second;
+		}
+	}
+	solution.routeStarts[params.nbVehicles] = pos;
+	params.penaltyCapacity = coarseParams.penaltyCapacity;
+	params.penaltyDuration = coarseParams.penaltyDuration;
+	if (!localSearch.run(solution, params.penaltyCapacity, params.penaltyDuration)) localSearch.resume(solution);
+	population.addIndividual(solution, true);
+	if (!solution.eval.isFeasible)
 	{
-		result.chromT[j % params.nbClients] = parent1.chromT[j % params.nbClients];
-		freqClient[result.chromT[j % params.nbClients]] = true;
-		j++;
+		if (!localSearch.repair(solution, params.penaltyCapacity*10., params.penaltyDuration*10.)) localSearch.resume(solution);
+		if (solution.eval.isFeasible) population.addIndividual(solution, false);
 	}
+	if (params.verbose) std::cout << "----- UNCOARSENING: SOLUTION OF " << params.nbClients << " CUSTOMERS REFINED TO A COST OF " << solution.eval.penalizedCost << std::endl;
+	return (population.getBestFound() != NULL);
+}
 
-	// Fill the remaining elements in the order given by the second parent
-	for (int i = 1; i <= params.nbClients; i++)
+bool Genetic::crossoverOX(Individual & result, const Individual & parent1, const Individual & parent2)
+{
+	params.stats.nbCrossovers++;
+
+	// The timer of the crossover stops before the Split of the offspring, which has its own timer
 	{
-		int temp = parent2.chromT[(end + i) % params.nbClients];
-		if (freqClient[temp] == false)
+		PhaseTimer timer(params.stats.timeCrossover, params.traceBuffers[0], "crossoverOX");
+
+		// Frequency table to track the customers which have been already inserted
+		std::fill(freqClient.begin(), freqClient.end(), false);
+
+		// Picking the beginning and end of the crossover zone
+		std::uniform_int_distribution<> distr(0, params.nbClients-1);
+		int start = distr(params.ran);
+		int end = distr(params.ran);
+
+		// Avoid that start and end coincide by accident
+		while (end == start) end = distr(params.ran);
+
+		// Copy from start to end
+		int j = start;
+		while (j % params.nbClients != (end + 1) % params.nbClients)
 		{
-			result.chromT[j % params.nbClients] = temp;
+			result.chromT[j % params.nbClients] = parent1.chromT[j % params.nbClients];
+			freqClient[result.chromT[j % params.nbClients]] = true;
 			j++;
 		}
+
+		// Fill the remaining elements in the order given by the second parent
+		for (int i = 1; i <= params.nbClients; i++)
+		{
+			int temp = parent2.chromT[(end + i) % params.nbClients];
+			if (freqClient[temp] == false)
+			{
+				result.chromT[j % params.nbClients] = temp;
+				j++;
+			}
+		}
+
+		// Skipping the offspring if its giant tour has been produced recently, otherwise memorizing it in place of the oldest one
+		if (params.ap.nbRecentGiantTours > 0)
+		{
+			size_t giantTourHash = result.hashGiantTour();
+			if (recentGiantTours.count(giantTourHash)) return false;
+			if ((int)recentGiantToursOrder.size() < params.ap.nbRecentGiantTours) recentGiantToursOrder.push_back(giantTourHash);
+			else
+			{
+				recentGiantTours.erase(recentGiantToursOrder[posRecentGiantTours]);
+				recentGiantToursOrder[posRecentGiantTours] = giantTourHash;
+			}
+			recentGiantTours.insert(giantTourHash);
+			posRecentGiantTours = (posRecentGiantTours + 1) % params.ap.nbRecentGiantTours;
+		}
 	}
 
 	// Complete the individual with the Split algorithm
 	split.generalSplit(result, parent1.eval.nbRoutes);
+	return true;
 }
 
 Genetic::Genetic(Params & params) : 
@@ -82,5 +360,7 @@ Genetic::Genetic(Params & params) :
 	split(params),
 	localSearch(params),
 	population(params,this->split,this->localSearch),
-	offspring(params){}
+	offspring(params),
+	freqClient(params.nbClients + 1, false),
+	posRecentGiantTours(0){}
 
@@ -35,13 +35,28 @@ public:
 	LocalSearch localSearch;		// Local Search structure
 	Population population;			// Population (public for now to give access to the solutions, but should be be improved later on)
 	Individual offspring;			// First individual to be used as input for the crossover
+	std::vector <bool> freqClient;	// (Crossover) Tells which customers have been already inserted in the offspring
+	std::unordered_set <size_t> recentGiantTours;	// Hashes of the giant tours of the last params.ap.nbRecentGiantTours distinct offspring
+	std::vector <size_t> recentGiantToursOrder;		// Same hashes, in a circular buffer following their order of production
+	int posRecentGiantTours;						// Position of the next hash in the circular buffer
 
 	// OX Crossover
-	void crossoverOX(Individual & result, const Individual & parent1, const Individual & parent2);
+	// Returns false, without applying Split, if the giant tour of the offspring is one of the recent giant tours (only when params.ap.nbRecentGiantTours > 0)
+	bool crossoverOX(Individual & result, const Individual & parent1, const Individual & parent2);
 
     // Running the genetic algorithm until maxIterNonProd consecutive iterations or a time limit
     void run() ;
 
+	// Decomposition phase: the routes of the best feasible solution are grouped by polar angle into subproblems of about params.ap.sizeDecomposition customers
+	// Each subproblem is solved by its own genetic algorithm in a separate thread, and the improved routes are merged back into a solution added to the population
+	// Returns true if this solution is a new best solution
+	bool decompose();
+
+	// Multilevel mode: pairs of close customers are merged into the nodes of a coarser instance, which is solved by a nested genetic algorithm (itself coarsening params.ap.nbCoarseningLevels-1 more times)
+	// The solution of the coarser instance is then projected on this instance and refined by the local search
+	// Returns true if this gives a feasible solution, which is added to the population (otherwise the genetic algorithm is run on this instance)
+	bool solveCoarseInstance();
+
 	// Constructor
 	Genetic(Params & params);
 };
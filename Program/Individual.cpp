@@ -3,28 +3,66 @@
 void Individual::evaluateCompleteCost(const Params & params)
 {
 	eval = EvalIndiv();
+	solutionHash = 0;
 	for (int r = 0; r < params.nbVehicles; r++)
 	{
-		if (!chromR[r].empty())
+		RouteSequence myRoute = route(r);
+		if (!myRoute.empty())
 		{
-			double distance = params.timeCost[0][chromR[r][0]];
-			double load = params.cli[chromR[r][0]].demand;
-			double service = params.cli[chromR[r][0]].serviceDuration;
-			predecessors[chromR[r][0]] = 0;
-			for (int i = 1; i < (int)chromR[r].size(); i++)
+			// The hash of a route is calculated in the direction starting with its smallest extremity, and the hashes of the routes are summed
+			// The load is calculated in the same pass, and also identifies the route in the cache of route evaluations
+			bool isReversed = (myRoute.front() > myRoute.back());
+			size_t routeHash = 0;
+			double routeLoad = 0.;
+			if (!isReversed) for (int i = 0; i < myRoute.size(); i++) { routeHash = mixHash(routeHash + myRoute[i]); routeLoad += params.cli[myRoute[i]].demand; }
+			else for (int i = myRoute.size() - 1; i >= 0; i--) { routeHash = mixHash(routeHash + myRoute[i]); routeLoad += params.cli[myRoute[i]].demand; }
+			solutionHash += mixHash(routeHash);
+
+			predecessors[myRoute[0]] = 0;
+			for (int i = 1; i < myRoute.size(); i++)
+			{
+				predecessors[myRoute[i]] = myRoute[i-1];
+				successors[myRoute[i-1]] = myRoute[i];
+			}
+			successors[myRoute.back()] = 0;
+
+			// The cache key also depends on the orientation of the route, as the distances may be asymmetric
+			RouteEvaluation * cachedEvaluation = NULL;
+			size_t key = mixHash(routeHash + isReversed);
+			if (!params.routeCache.empty())
+			{
+				cachedEvaluation = &params.routeCache[key % params.routeCache.size()];
+				params.nbRouteCacheLookups++;
+			}
+			RouteEvaluation evaluation;
+			if (cachedEvaluation != NULL && cachedEvaluation->key == key && cachedEvaluation->nbCustomers == myRoute.size()
+				&& cachedEvaluation->first == myRoute.front() && cachedEvaluation->last == myRoute.back() && cachedEvaluation->load == routeLoad)
+			{
+				evaluation = *cachedEvaluation;
+				params.nbRouteCacheHits++;
+			}
+			else
 			{
-				distance += params.timeCost[chromR[r][i-1]][chromR[r][i]];
-				load += params.cli[chromR[r][i]].demand;
-				service += params.cli[chromR[r][i]].serviceDuration;
-				predecessors[chromR[r][i]] = chromR[r][i-1];
-				successors[chromR[r][i-1]] = chromR[r][i];
+				evaluation.key = key;
+				evaluation.nbCustomers = myRoute.size();
+				evaluation.first = myRoute.front();
+				evaluation.last = myRoute.back();
+				evaluation.load = routeLoad;
+				evaluation.distance = params.timeCost[0][myRoute[0]];
+				evaluation.service = params.cli[myRoute[0]].serviceDuration;
+				for (int i = 1; i < myRoute.size(); i++)
+				{
+					evaluation.distance += params.timeCost[myRoute[i-1]][myRoute[i]];
+					evaluation.service += params.cli[myRoute[i]].serviceDuration;
+				}
+				evaluation.distance += params.timeCost[myRoute.back()][0];
+				if (cachedEvaluation != NULL) *cachedEvaluation = evaluation;
 			}
-			successors[chromR[r][chromR[r].size()-1]] = 0;
-			distance += params.timeCost[chromR[r][chromR[r].size()-1]][0];
-			eval.distance += distance;
+
+			eval.distance += evaluation.distance;
 			eval.nbRoutes++;
-			if (load > params.vehicleCapacity) eval.capacityExcess += load - params.vehicleCapacity;
-			if (distance + service > params.durationLimit) eval.durationExcess += distance + service - params.durationLimit;
+			if (evaluation.load > params.vehicleCapacity) eval.capacityExcess += evaluation.load - params.vehicleCapacity;
+			if (evaluation.distance + evaluation.service > params.durationLimit) eval.durationExcess += evaluation.distance + evaluation.service - params.durationLimit;
 		}
 	}
 
@@ -32,15 +70,24 @@ void Individual::evaluateCompleteCost(const Params & params)
 	eval.isFeasible = (eval.capacityExcess < MY_EPSILON && eval.durationExcess < MY_EPSILON);
 }
 
+size_t Individual::hashGiantTour() const
+{
+	size_t giantTourHash = 0;
+	for (int i : chromT) giantTourHash = mixHash(giantTourHash + i);
+	return giantTourHash;
+}
+
 Individual::Individual(Params & params)
 {
 	successors = std::vector <int>(params.nbClients + 1);
 	predecessors = std::vector <int>(params.nbClients + 1);
-	chromR = std::vector < std::vector <int> >(params.nbVehicles);
+	routeStarts = std::vector <int>(params.nbVehicles + 1, 0);
 	chromT = std::vector <int>(params.nbClients);
 	for (int i = 0; i < params.nbClients; i++) chromT[i] = i + 1;
 	std::shuffle(chromT.begin(), chromT.end(), params.ran);
 	eval.penalizedCost = 1.e30;	
+	solutionHash = 0;
+	proximitySlot = -1;
 }
 
 Individual::Individual(Params & params, std::string fileName) : Individual(params)
@@ -53,19 +100,20 @@ Individual::Individual(Params & params, std::string fileName) : Individual(param
 		std::string inputString;
 		inputFile >> inputString;
 		// Loops in the input file as long as the first line keyword is "Route"
-		for (int r = 0; inputString == "Route"; r++)
+		int r = 0;
+		for (; inputString == "Route"; r++)
 		{
+			if (r >= params.nbVehicles) throw std::string("Input solution has more routes than the number of vehicles");
+			routeStarts[r] = (int)chromT.size();
 			inputFile >> inputString;
 			getline(inputFile, inputString);
 			std::stringstream ss(inputString);
 			int inputCustomer;
 			while (ss >> inputCustomer) // Loops as long as there is an integer to read in this route
-			{
 				chromT.push_back(inputCustomer);
-				chromR[r].push_back(inputCustomer);
-			}
 			inputFile >> inputString;
 		}
+		for (; r <= params.nbVehicles; r++) routeStarts[r] = (int)chromT.size();
 		if (inputString == "Cost") inputFile >> readCost;
 		else throw std::string("Unexpected token in input solution");
 
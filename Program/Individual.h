@@ -35,21 +35,51 @@ struct EvalIndiv
 	bool isFeasible = false;		// Feasibility status of the individual
 };
 
+// Sequence of deliveries of a route, which is a segment of the giant tour (read-only, and usable in range-based loops)
+struct RouteSequence
+{
+	const int * first;		// First customer of the route
+	const int * last;		// Position after the last customer of the route
+	const int * begin() const { return first; }
+	const int * end() const { return last; }
+	int size() const { return (int)(last - first); }
+	bool empty() const { return first == last; }
+	int front() const { return *first; }
+	int back() const { return *(last - 1); }
+	int operator[](int i) const { return first[i]; }
+};
+
 class Individual
 {
 public:
 
   EvalIndiv eval;															// Solution cost parameters
-  std::vector < int > chromT ;												// Giant tour representing the individual
-  std::vector < std::vector <int> > chromR ;								// For each vehicle, the associated sequence of deliveries (complete solution)
+  std::vector < int > chromT ;												// Giant tour representing the individual. Once the routes are known, it contains their sequences of deliveries one after the other
+  std::vector < int > routeStarts ;											// For each vehicle, position in chromT of its first delivery, routeStarts[nbVehicles] being the end of the last route (all routes are empty until the giant tour is split)
   std::vector < int > successors ;											// For each node, the successor in the solution (can be the depot 0)
   std::vector < int > predecessors ;										// For each node, the predecessor in the solution (can be the depot 0)
-  std::multiset < std::pair < double, Individual* > > indivsPerProximity ;	// The other individuals in the population, ordered by increasing proximity (the set container follows a natural ordering based on the first value of the pair)
+  size_t solutionHash;														// Hash of the routes, which does not depend on their order and orientation (clones have the same hash)
+  int proximitySlot;														// Slot of the individual in the proximity structure of its subpopulation (see Population)
   double biasedFitness;														// Biased fitness of the solution
+  double diversityContribution;												// Average broken pairs distance with the nbClose closest individuals of its subpopulation (kept up to date by the population)
 
-  // Measuring cost and feasibility of an Individual from the information of chromR (needs chromR filled and access to Params)
+  // Sequence of deliveries of vehicle r (complete solution)
+  RouteSequence route(int r) const { return RouteSequence{ chromT.data() + routeStarts[r], chromT.data() + routeStarts[r + 1] }; }
+
+  // Measuring cost and feasibility of an Individual from the information of its routes (needs the routes filled and access to Params)
   void evaluateCompleteCost(const Params & params);
 
+  // Hash of the giant tour chromT
+  size_t hashGiantTour() const;
+
+  // Mixing function used to combine the hash values (finalizer of splitmix64)
+  static inline size_t mixHash(size_t x)
+  {
+	  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	  return x ^ (x >> 31);
+  }
+
   // Constructor of a random individual containing only a giant tour with a shuffled visit order
   Individual(Params & params);
 
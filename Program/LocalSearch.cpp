@@ -1,34 +1,231 @@
 #include "LocalSearch.h" 
 
-void LocalSearch::run(Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS)
+bool LocalSearch::run(Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS)
 {
+	PhaseTimer timer(params.stats.timeLocalSearch, traceBuffer, "LocalSearch::run");
+	params.stats.nbLocalSearches++;
 	this->penaltyCapacityLS = penaltyCapacityLS;
 	this->penaltyDurationLS = penaltyDurationLS;
 	loadIndividual(indiv);
 
 	// Shuffling the order of the nodes explored by the LS to allow for more diversity in the search
-	std::shuffle(orderNodes.begin(), orderNodes.end(), params.ran);
-	std::shuffle(orderRoutes.begin(), orderRoutes.end(), params.ran);
+	std::shuffle(orderNodes.begin(), orderNodes.end(), ran);
+	std::shuffle(orderRoutes.begin(), orderRoutes.end(), ran);
 	for (int i = 1; i <= params.nbClients; i++)
-		if (params.ran() % params.ap.nbGranular == 0)  // O(n/nbGranular) calls to the inner function on average, to achieve linear-time complexity overall
-			std::shuffle(params.correlatedVertices[i].begin(), params.correlatedVertices[i].end(), params.ran);
+		if (ran() % params.ap.nbGranular == 0)  // O(n/nbGranular) calls to the inner function on average, to achieve linear-time complexity overall
+			std::shuffle(params.correlatedVertices[i].begin(), params.correlatedVertices[i].end(), ran);
 
+	nbCalls++;
+
+	// With several threads and enough routes, the groups of neighboring routes are first improved in parallel, and the sequential search then starts at the second loop to reconcile the groups
+	if (!workers.empty() && params.nbVehicles - (int)emptyRoutes.size() >= 4 * (int)workers.size())
+	{
+		searchRouteGroups(indiv);
+		startSearch(1);
+	}
+	else startSearch(0);
+	if (!searchLoops()) { nbInterruptions++; return false; }
+
+	// Register the solution produced by the LS in the individual
+	exportIndividual(indiv);
+	return true;
+}
+
+bool LocalSearch::repair(Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS)
+{
+	PhaseTimer timer(params.stats.timeRepair, traceBuffer, "LocalSearch::repair");
+	params.stats.nbRepairs++;
+	// The solution of the last run is still held in the linked lists: only the penalties of the routes change with the new penalty values
+	if (!isLoaded(indiv)) throw std::string("Repair called on a solution which is not the one of the last local search");
+	this->penaltyCapacityLS = penaltyCapacityLS;
+	this->penaltyDurationLS = penaltyDurationLS;
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		routes[r].penalty = penaltyExcessDuration(routes[r].duration) + penaltyExcessLoad(routes[r].load);
+		routes[r].whenLastTestedSWAPStar = -1;
+	}
+
+	// All moves are tested again, as in a new search. The route "when" counters are left untouched to keep the SWAP* insertion memory, which does not depend on the penalties
+	for (int i = 1; i <= params.nbClients; i++) clients[i].whenLastTestedRI = -1;
+	std::shuffle(orderNodes.begin(), orderNodes.end(), ran);
+	std::shuffle(orderRoutes.begin(), orderRoutes.end(), ran);
+
+	// As in run, the first loop does not test moves towards empty routes to avoid increasing too much the fleet size
+	startSearch(0);
+	if (!searchLoops()) return false;
+	exportIndividual(indiv);
+	return true;
+}
+
+void LocalSearch::searchRouteGroups(const Individual & indiv)
+{
+	TraceScope traceScope(traceBuffer, "searchRouteGroups");
+
+	// Groups of routes with consecutive polar angles of their barycenters, with similar numbers of customers
+	// Each group receives a share of the empty routes, so that different groups never use the same empty route
+	routePolarAngles.clear();
+	for (int r = 0; r < params.nbVehicles; r++)
+		routePolarAngles.push_back(std::pair <double, int>(routes[r].polarAngleBarycenter, r));
+	std::sort(routePolarAngles.begin(), routePolarAngles.end()); // empty routes have a polar angle of 1.e30, and therefore come last
+	int nbGroups = (int)workers.size();
+	int nbCustomersGrouped = 0;
+	int nbEmptyRoutes = 0;
+	for (LocalSearch & worker : workers)
+	{
+		for (int r : worker.routeGroup)
+		{
+			// The routes of the previous group leave the search of the worker, and release their SWAP* insertion memory
+			worker.sectorIndex.remove(r);
+			if (!worker.bestInsertClient[r].empty())
+			{
+				worker.freeBestInsertRows.emplace_back();
+				worker.freeBestInsertRows.back().swap(worker.bestInsertClient[r]);
+			}
+		}
+		worker.routeGroup.clear();
+	}
+	for (std::pair <double, int> & myPair : routePolarAngles)
+	{
+		Route * myRoute = &routes[myPair.second];
+		if (myRoute->nbCustomers > 0)
+		{
+			groupOfRoute[myRoute->cour] = std::min<int>(nbGroups - 1, (nbCustomersGrouped * nbGroups) / params.nbClients);
+			nbCustomersGrouped += myRoute->nbCustomers;
+		}
+		else groupOfRoute[myRoute->cour] = nbEmptyRoutes++ % nbGroups;
+		workers[groupOfRoute[myRoute->cour]].routeGroup.push_back(myRoute->cour);
+	}
+
+	// Each group is improved by its own worker and thread, with its own random number generator
+	for (std::minstd_rand & workerRan : workerRans) workerRan.seed(ran());
+	{
+		std::lock_guard < std::mutex > lock(workerMutex);
+		groupSolution = &indiv;
+		nbThreadsRunning = (int)workerThreads.size();
+		nbParallelSearches++;
+	}
+	workerStart.notify_all();
+	workers[0].searchRouteGroup(indiv, penaltyCapacityLS, penaltyDurationLS);
+	{
+		std::unique_lock < std::mutex > lock(workerMutex);
+		workerEnd.wait(lock, [this] { return nbThreadsRunning == 0; });
+	}
+
+	// Collecting the routes of all groups
+	int pos = 0;
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		groupRouteStarts[r] = pos;
+		for (Node * myNode = workers[groupOfRoute[r]].routes[r].depot->next; !myNode->isDepot; myNode = myNode->next)
+			groupChromT[pos++] = myNode->cour;
+	}
+	groupRouteStarts[params.nbVehicles] = pos;
+	loadRoutes(groupChromT, groupRouteStarts, orderRoutes);
+}
+
+void LocalSearch::searchRouteGroup(const Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS)
+{
+	TraceScope traceScope(traceBuffer, "searchRouteGroup");
+	this->penaltyCapacityLS = penaltyCapacityLS;
+	this->penaltyDurationLS = penaltyDurationLS;
+	loadRoutes(indiv.chromT, indiv.routeStarts, routeGroup);
+
+	// Only the customers and routes of the group are explored
+	orderNodes.clear();
+	for (int r : routeGroup)
+		orderNodes.insert(orderNodes.end(), indiv.route(r).begin(), indiv.route(r).end());
+	orderRoutes = routeGroup;
+	std::shuffle(orderNodes.begin(), orderNodes.end(), ran);
+	std::shuffle(orderRoutes.begin(), orderRoutes.end(), ran);
+	startSearch(0);
+	searchLoops(); // The search of a group also ends if the budget of the call is exhausted
+}
+
+void LocalSearch::runWorkerThread(int w)
+{
+	int nbParallelSearchesDone = 0;
+	while (true)
+	{
+		{
+			std::unique_lock < std::mutex > lock(workerMutex);
+			workerStart.wait(lock, [this, nbParallelSearchesDone] { return areThreadsStopping || nbParallelSearches > nbParallelSearchesDone; });
+			if (areThreadsStopping) return;
+			nbParallelSearchesDone = nbParallelSearches;
+		}
+		workers[w].searchRouteGroup(*groupSolution, penaltyCapacityLS, penaltyDurationLS);
+		{
+			std::lock_guard < std::mutex > lock(workerMutex);
+			if (--nbThreadsRunning == 0) workerEnd.notify_one();
+		}
+	}
+}
+
+bool LocalSearch::isLoaded(const Individual & indiv)
+{
+	for (int i = 1; i <= params.nbClients; i++)
+		if (indiv.successors[i] != clients[i].next->cour || indiv.predecessors[i] != clients[i].prev->cour)
+			return false;
+	return true;
+}
+
+bool LocalSearch::resume(Individual & indiv)
+{
+	PhaseTimer timer(params.stats.timeLocalSearch, traceBuffer, "LocalSearch::resume");
+	bool isCompleted = searchLoops();
+	while (!isCompleted && (params.ap.timeLimit == 0 || (double)(clock() - params.startTime) / (double)CLOCKS_PER_SEC < params.ap.timeLimit))
+		isCompleted = searchLoops();
+	exportIndividual(indiv);
+	return isCompleted;
+}
+
+void LocalSearch::startSearch(int firstLoopID)
+{
 	searchCompleted = false;
-	for (loopID = 0; !searchCompleted; loopID++)
+	loopID = firstLoopID;
+	posNodeLoop = -1;
+	posRouteLoop = 0;
+}
+
+bool LocalSearch::searchLoops()
+{
+	nbMovesStartCall = nbMoves;
+	clockStartCall = clock();
+	nbBudgetChecks = 0;
+	while (true)
 	{
-		if (loopID > 1) // Allows at least two loops since some moves involving empty routes are not checked at the first loop
-			searchCompleted = true;
+		if (posNodeLoop == -1 && searchCompleted) return true;
+		TraceScope traceScope(traceBuffer, "loop"); // One event per loop, or per part of a loop interrupted by the budget of the call
+		if (posNodeLoop == -1) // Starting a new loop
+		{
+			nbLoops++;
+			if (loopID > 1) // Allows at least two loops since some moves involving empty routes are not checked at the first loop
+				searchCompleted = true;
+
+			// The first two loops explore all nodes, and the next loops only explore the nodes close to the modifications of the previous loop
+			if (loopID >= 1)
+			{
+				nodesToExplore.swap(activeNodes);
+				activeNodes.clear();
+				for (int i : nodesToExplore) clients[i].isActive = false;
+				std::shuffle(nodesToExplore.begin(), nodesToExplore.end(), ran);
+			}
+			posNodeLoop = 0;
+			posRouteLoop = 0;
+		}
+		const std::vector < int > & myNodes = (loopID <= 1) ? orderNodes : nodesToExplore;
 
 		/* CLASSICAL ROUTE IMPROVEMENT (RI) MOVES SUBJECT TO A PROXIMITY RESTRICTION */
-		for (int posU = 0; posU < params.nbClients; posU++)
+		for ( ; posNodeLoop < (int)myNodes.size(); posNodeLoop++)
 		{
-			nodeU = &clients[orderNodes[posU]];
+			if (isBudgetExhausted()) return false;
+			nodeU = &clients[myNodes[posNodeLoop]];
+			if (nodeU->whenLoaded != nbLoads) continue; // Customer outside of the group of a worker of the parallel search
 			int lastTestRINodeU = nodeU->whenLastTestedRI;
 			nodeU->whenLastTestedRI = nbMoves;
 			for (int posV = 0; posV < (int)params.correlatedVertices[nodeU->cour].size(); posV++)
 			{
 				nodeV = &clients[params.correlatedVertices[nodeU->cour][posV]];
-				if (loopID == 0 || std::max<int>(nodeU->route->whenLastModified, nodeV->route->whenLastModified) > lastTestRINodeU) // only evaluate moves involving routes that have been modified since last move evaluations for nodeU
+				if (nodeV->whenLoaded == nbLoads && (loopID == 0 || std::max<int>(nodeU->route->whenLastModified, nodeV->route->whenLastModified) > lastTestRINodeU)) // only evaluate moves involving routes that have been modified since last move evaluations for nodeU
 				{
 					// Randomizing the order of the neighborhoods within this loop does not matter much as we are already randomizing the order of the node pairs (and it's not very common to find improving moves of different types for the same node pair)
 					setLocalVariablesRouteU();
@@ -73,14 +270,21 @@ void LocalSearch::run(Individual & indiv, double penaltyCapacityLS, double penal
 		if (params.ap.useSwapStar == 1 && params.areCoordinatesProvided)
 		{
 			/* (SWAP*) MOVES LIMITED TO ROUTE PAIRS WHOSE CIRCLE SECTORS OVERLAP */
-			for (int rU = 0; rU < params.nbVehicles; rU++)
+			TraceScope traceScopeSwapStar(traceBuffer, "SWAP*");
+			sectorIndex.refreshMaxLength();
+			for ( ; posRouteLoop < (int)orderRoutes.size(); posRouteLoop++)
 			{
-				routeU = &routes[orderRoutes[rU]];
+				if (isBudgetExhausted()) return false;
+				routeU = &routes[orderRoutes[posRouteLoop]];
 				int lastTestSWAPStarRouteU = routeU->whenLastTestedSWAPStar;
 				routeU->whenLastTestedSWAPStar = nbMoves;
-				for (int rV = 0; rV < params.nbVehicles; rV++)
+				if (routeU->nbCustomers == 0) continue;
+
+				// Only enumerating the non-empty routes whose sectors overlap, using the index of circle sectors
+				sectorIndex.getOverlaps(routeU->sector, overlappingRoutes);
+				for (int rV : overlappingRoutes)
 				{
-					routeV = &routes[orderRoutes[rV]];
+					routeV = &routes[rV];
 					if (routeU->nbCustomers > 0 && routeV->nbCustomers > 0 && routeU->cour < routeV->cour
 						&& (loopID == 0 || std::max<int>(routeU->whenLastModified, routeV->whenLastModified)
 							> lastTestSWAPStarRouteU))
@@ -89,10 +293,9 @@ void LocalSearch::run(Individual & indiv, double penaltyCapacityLS, double penal
 				}
 			}
 		}
+		posNodeLoop = -1;
+		loopID++;
 	}
-
-	// Register the solution produced by the LS in the individual
-	exportIndividual(indiv);
 }
 
 void LocalSearch::setLocalVariablesRouteU()
@@ -126,6 +329,7 @@ void LocalSearch::setLocalVariablesRouteV()
 
 bool LocalSearch::move1()
 {
+	nbMoveEvaluations[1]++;
 	double costSuppU = params.timeCost[nodeUPrevIndex][nodeXIndex] - params.timeCost[nodeUPrevIndex][nodeUIndex] - params.timeCost[nodeUIndex][nodeXIndex];
 	double costSuppV = params.timeCost[nodeVIndex][nodeUIndex] + params.timeCost[nodeUIndex][nodeYIndex] - params.timeCost[nodeVIndex][nodeYIndex];
 
@@ -146,16 +350,23 @@ bool LocalSearch::move1()
 	if (costSuppU + costSuppV > -MY_EPSILON) return false;
 	if (nodeUIndex == nodeYIndex) return false;
 
+	Node * nodeUPrev = nodeU->prev;
 	insertNode(nodeU, nodeV);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[1]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	if (!intraRouteMove) updateRouteData(routeV);
+	if (intraRouteMove) updateRouteData(routeU, firstInRoute(nodeUPrev, nodeV), lastInRoute(nodeX, nodeY));
+	else
+	{
+		updateRouteData(routeU, nodeUPrev, NULL);
+		updateRouteData(routeV, nodeV, NULL);
+	}
 	return true;
 }
 
 bool LocalSearch::move2()
 {
+	nbMoveEvaluations[2]++;
 	double costSuppU = params.timeCost[nodeUPrevIndex][nodeXNextIndex] - params.timeCost[nodeUPrevIndex][nodeUIndex] - params.timeCost[nodeXIndex][nodeXNextIndex];
 	double costSuppV = params.timeCost[nodeVIndex][nodeUIndex] + params.timeCost[nodeXIndex][nodeYIndex] - params.timeCost[nodeVIndex][nodeYIndex];
 
@@ -176,17 +387,25 @@ bool LocalSearch::move2()
 	if (costSuppU + costSuppV > -MY_EPSILON) return false;
 	if (nodeU == nodeY || nodeV == nodeX || nodeX->isDepot) return false;
 
+	Node * nodeUPrev = nodeU->prev;
+	Node * nodeXNext = nodeX->next;
 	insertNode(nodeU, nodeV);
 	insertNode(nodeX, nodeU);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[2]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	if (!intraRouteMove) updateRouteData(routeV);
+	if (intraRouteMove) updateRouteData(routeU, firstInRoute(nodeUPrev, nodeV), lastInRoute(nodeXNext, nodeY));
+	else
+	{
+		updateRouteData(routeU, nodeUPrev, NULL);
+		updateRouteData(routeV, nodeV, NULL);
+	}
 	return true;
 }
 
 bool LocalSearch::move3()
 {
+	nbMoveEvaluations[3]++;
 	double costSuppU = params.timeCost[nodeUPrevIndex][nodeXNextIndex] - params.timeCost[nodeUPrevIndex][nodeUIndex] - params.timeCost[nodeUIndex][nodeXIndex] - params.timeCost[nodeXIndex][nodeXNextIndex];
 	double costSuppV = params.timeCost[nodeVIndex][nodeXIndex] + params.timeCost[nodeXIndex][nodeUIndex] + params.timeCost[nodeUIndex][nodeYIndex] - params.timeCost[nodeVIndex][nodeYIndex];
 
@@ -207,17 +426,25 @@ bool LocalSearch::move3()
 	if (costSuppU + costSuppV > -MY_EPSILON) return false;
 	if (nodeU == nodeY || nodeX == nodeV || nodeX->isDepot) return false;
 
+	Node * nodeUPrev = nodeU->prev;
+	Node * nodeXNext = nodeX->next;
 	insertNode(nodeX, nodeV);
 	insertNode(nodeU, nodeX);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[3]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	if (!intraRouteMove) updateRouteData(routeV);
+	if (intraRouteMove) updateRouteData(routeU, firstInRoute(nodeUPrev, nodeV), lastInRoute(nodeXNext, nodeY));
+	else
+	{
+		updateRouteData(routeU, nodeUPrev, NULL);
+		updateRouteData(routeV, nodeV, NULL);
+	}
 	return true;
 }
 
 bool LocalSearch::move4()
 {
+	nbMoveEvaluations[4]++;
 	double costSuppU = params.timeCost[nodeUPrevIndex][nodeVIndex] + params.timeCost[nodeVIndex][nodeXIndex] - params.timeCost[nodeUPrevIndex][nodeUIndex] - params.timeCost[nodeUIndex][nodeXIndex];
 	double costSuppV = params.timeCost[nodeVPrevIndex][nodeUIndex] + params.timeCost[nodeUIndex][nodeYIndex] - params.timeCost[nodeVPrevIndex][nodeVIndex] - params.timeCost[nodeVIndex][nodeYIndex];
 
@@ -238,16 +465,24 @@ bool LocalSearch::move4()
 	if (costSuppU + costSuppV > -MY_EPSILON) return false;
 	if (nodeUIndex == nodeVPrevIndex || nodeUIndex == nodeYIndex) return false;
 
+	Node * nodeUPrev = nodeU->prev;
+	Node * nodeVPrev = nodeV->prev;
 	swapNode(nodeU, nodeV);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[4]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	if (!intraRouteMove) updateRouteData(routeV);
+	if (intraRouteMove) updateRouteData(routeU, firstInRoute(nodeUPrev, nodeVPrev), lastInRoute(nodeX, nodeY));
+	else
+	{
+		updateRouteData(routeU, nodeUPrev, NULL);
+		updateRouteData(routeV, nodeVPrev, NULL);
+	}
 	return true;
 }
 
 bool LocalSearch::move5()
 {
+	nbMoveEvaluations[5]++;
 	double costSuppU = params.timeCost[nodeUPrevIndex][nodeVIndex] + params.timeCost[nodeVIndex][nodeXNextIndex] - params.timeCost[nodeUPrevIndex][nodeUIndex] - params.timeCost[nodeXIndex][nodeXNextIndex];
 	double costSuppV = params.timeCost[nodeVPrevIndex][nodeUIndex] + params.timeCost[nodeXIndex][nodeYIndex] - params.timeCost[nodeVPrevIndex][nodeVIndex] - params.timeCost[nodeVIndex][nodeYIndex];
 
@@ -268,17 +503,26 @@ bool LocalSearch::move5()
 	if (costSuppU + costSuppV > -MY_EPSILON) return false;
 	if (nodeU == nodeV->prev || nodeX == nodeV->prev || nodeU == nodeY || nodeX->isDepot) return false;
 
+	Node * nodeUPrev = nodeU->prev;
+	Node * nodeXNext = nodeX->next;
+	Node * nodeVPrev = nodeV->prev;
 	swapNode(nodeU, nodeV);
 	insertNode(nodeX, nodeU);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[5]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	if (!intraRouteMove) updateRouteData(routeV);
+	if (intraRouteMove) updateRouteData(routeU, firstInRoute(nodeUPrev, nodeVPrev), lastInRoute(nodeXNext, nodeY));
+	else
+	{
+		updateRouteData(routeU, nodeUPrev, NULL);
+		updateRouteData(routeV, nodeVPrev, NULL);
+	}
 	return true;
 }
 
 bool LocalSearch::move6()
 {
+	nbMoveEvaluations[6]++;
 	double costSuppU = params.timeCost[nodeUPrevIndex][nodeVIndex] + params.timeCost[nodeYIndex][nodeXNextIndex] - params.timeCost[nodeUPrevIndex][nodeUIndex] - params.timeCost[nodeXIndex][nodeXNextIndex];
 	double costSuppV = params.timeCost[nodeVPrevIndex][nodeUIndex] + params.timeCost[nodeXIndex][nodeYNextIndex] - params.timeCost[nodeVPrevIndex][nodeVIndex] - params.timeCost[nodeYIndex][nodeYNextIndex];
 
@@ -299,17 +543,27 @@ bool LocalSearch::move6()
 	if (costSuppU + costSuppV > -MY_EPSILON) return false;
 	if (nodeX->isDepot || nodeY->isDepot || nodeY == nodeU->prev || nodeU == nodeY || nodeX == nodeV || nodeV == nodeX->next) return false;
 
+	Node * nodeUPrev = nodeU->prev;
+	Node * nodeXNext = nodeX->next;
+	Node * nodeYNext = nodeY->next;
+	Node * nodeVPrev = nodeV->prev;
 	swapNode(nodeU, nodeV);
 	swapNode(nodeX, nodeY);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[6]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	if (!intraRouteMove) updateRouteData(routeV);
+	if (intraRouteMove) updateRouteData(routeU, firstInRoute(nodeUPrev, nodeVPrev), lastInRoute(nodeXNext, nodeYNext));
+	else
+	{
+		updateRouteData(routeU, nodeUPrev, NULL);
+		updateRouteData(routeV, nodeVPrev, NULL);
+	}
 	return true;
 }
 
 bool LocalSearch::move7()
 {
+	nbMoveEvaluations[7]++;
 	if (nodeU->position > nodeV->position) return false;
 
 	double cost = params.timeCost[nodeUIndex][nodeVIndex] + params.timeCost[nodeXIndex][nodeYIndex] - params.timeCost[nodeUIndex][nodeXIndex] - params.timeCost[nodeVIndex][nodeYIndex] + nodeV->cumulatedReversalDistance - nodeX->cumulatedReversalDistance;
@@ -335,13 +589,15 @@ bool LocalSearch::move7()
 	nodeY->prev = nodeX;
 
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[7]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
+	updateRouteData(routeU, nodeU, nodeY);
 	return true;
 }
 
 bool LocalSearch::move8()
 {
+	nbMoveEvaluations[8]++;
 	double cost = params.timeCost[nodeUIndex][nodeVIndex] + params.timeCost[nodeXIndex][nodeYIndex] - params.timeCost[nodeUIndex][nodeXIndex] - params.timeCost[nodeVIndex][nodeYIndex]
 		+ nodeV->cumulatedReversalDistance + routeU->reversalDistance - nodeX->cumulatedReversalDistance
 		- routeU->penalty - routeV->penalty;
@@ -414,14 +670,16 @@ bool LocalSearch::move8()
 	}
 
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[8]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	updateRouteData(routeV);
+	updateRouteData(routeU, nodeU, NULL);
+	updateRouteData(routeV, depotV, NULL);
 	return true;
 }
 
 bool LocalSearch::move9()
 {
+	nbMoveEvaluations[9]++;
 	double cost = params.timeCost[nodeUIndex][nodeYIndex] + params.timeCost[nodeVIndex][nodeXIndex] - params.timeCost[nodeUIndex][nodeXIndex] - params.timeCost[nodeVIndex][nodeYIndex]
 		        - routeU->penalty - routeV->penalty;
 
@@ -476,14 +734,16 @@ bool LocalSearch::move9()
 	}
 
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[9]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	updateRouteData(routeV);
+	updateRouteData(routeU, nodeU, NULL);
+	updateRouteData(routeV, nodeV, NULL);
 	return true;
 }
 
 bool LocalSearch::swapStar()
 {
+	nbMoveEvaluations[0]++;
 	SwapStarElement myBestSwapStar;
 
 	// Preprocessing insertion costs
@@ -528,9 +788,9 @@ bool LocalSearch::swapStar()
 	{
 		SwapStarElement mySwapStar;
 		mySwapStar.U = nodeU;
-		mySwapStar.bestPositionU = bestInsertClient[routeV->cour][nodeU->cour].bestLocation[0];
+		mySwapStar.bestPositionU = getLocation(nodeU->bestInsert->bestLocation[0], routeV);
 		double deltaDistRouteU = params.timeCost[nodeU->prev->cour][nodeU->next->cour] - params.timeCost[nodeU->prev->cour][nodeU->cour] - params.timeCost[nodeU->cour][nodeU->next->cour];
-		double deltaDistRouteV = bestInsertClient[routeV->cour][nodeU->cour].bestCost[0];
+		double deltaDistRouteV = nodeU->bestInsert->bestCost[0];
 		mySwapStar.moveCost = deltaDistRouteU + deltaDistRouteV
 			+ penaltyExcessLoad(routeU->load - params.cli[nodeU->cour].demand) - routeU->penalty
 			+ penaltyExcessLoad(routeV->load + params.cli[nodeU->cour].demand) - routeV->penalty
@@ -546,8 +806,8 @@ bool LocalSearch::swapStar()
 	{
 		SwapStarElement mySwapStar;
 		mySwapStar.V = nodeV;
-		mySwapStar.bestPositionV = bestInsertClient[routeU->cour][nodeV->cour].bestLocation[0];
-		double deltaDistRouteU = bestInsertClient[routeU->cour][nodeV->cour].bestCost[0];
+		mySwapStar.bestPositionV = getLocation(nodeV->bestInsert->bestLocation[0], routeU);
+		double deltaDistRouteU = nodeV->bestInsert->bestCost[0];
 		double deltaDistRouteV = params.timeCost[nodeV->prev->cour][nodeV->next->cour] - params.timeCost[nodeV->prev->cour][nodeV->cour] - params.timeCost[nodeV->cour][nodeV->next->cour];
 		mySwapStar.moveCost = deltaDistRouteU + deltaDistRouteV
 			+ penaltyExcessLoad(routeU->load + params.cli[nodeV->cour].demand) - routeU->penalty
@@ -561,37 +821,91 @@ bool LocalSearch::swapStar()
 
 	if (myBestSwapStar.moveCost > -MY_EPSILON) return false;
 
+	// The insertion costs kept in memory are approximate, so the selected move is only applied if it is improving in double precision
+	if (getSwapStarCost(myBestSwapStar) > -MY_EPSILON) return false;
+
+	// Locating the first modification in each route (starting from the end depots)
+	Node * firstModifiedU = routeU->depot->prev;
+	Node * firstModifiedV = routeV->depot->prev;
+	if (myBestSwapStar.U != NULL)
+	{
+		firstModifiedU = firstInRoute(firstModifiedU, myBestSwapStar.U->prev);
+		firstModifiedV = firstInRoute(firstModifiedV, myBestSwapStar.bestPositionU);
+	}
+	if (myBestSwapStar.V != NULL)
+	{
+		firstModifiedV = firstInRoute(firstModifiedV, myBestSwapStar.V->prev);
+		firstModifiedU = firstInRoute(firstModifiedU, myBestSwapStar.bestPositionV);
+	}
+
 	// Applying the best move in case of improvement
 	if (myBestSwapStar.bestPositionU != NULL) insertNode(myBestSwapStar.U, myBestSwapStar.bestPositionU);
 	if (myBestSwapStar.bestPositionV != NULL) insertNode(myBestSwapStar.V, myBestSwapStar.bestPositionV);
 	nbMoves++; // Increment move counter before updating route data
+	nbMoveSuccesses[0]++;
 	searchCompleted = false;
-	updateRouteData(routeU);
-	updateRouteData(routeV);
+	updateRouteData(routeU, firstModifiedU, NULL);
+	updateRouteData(routeV, firstModifiedV, NULL);
 	return true;
 }
 
+double LocalSearch::getSwapStarCost(const SwapStarElement & move)
+{
+	double deltaDistRouteU = 0., deltaDistRouteV = 0.;
+	double demandU = 0., demandV = 0., serviceDurationU = 0., serviceDurationV = 0.;
+	if (move.U != NULL)
+	{
+		Node * U = move.U;
+		demandU = params.cli[U->cour].demand;
+		serviceDurationU = params.cli[U->cour].serviceDuration;
+		deltaDistRouteU += params.timeCost[U->prev->cour][U->next->cour] - params.timeCost[U->prev->cour][U->cour] - params.timeCost[U->cour][U->next->cour];
+		if (move.V != NULL && move.bestPositionU == move.V->prev) // Insertion in the place of V
+			deltaDistRouteV += params.timeCost[move.V->prev->cour][U->cour] + params.timeCost[U->cour][move.V->next->cour] - params.timeCost[move.V->prev->cour][move.V->next->cour];
+		else
+			deltaDistRouteV += deltaInsertion(U, move.bestPositionU);
+	}
+	if (move.V != NULL)
+	{
+		Node * V = move.V;
+		demandV = params.cli[V->cour].demand;
+		serviceDurationV = params.cli[V->cour].serviceDuration;
+		deltaDistRouteV += params.timeCost[V->prev->cour][V->next->cour] - params.timeCost[V->prev->cour][V->cour] - params.timeCost[V->cour][V->next->cour];
+		if (move.U != NULL && move.bestPositionV == move.U->prev) // Insertion in the place of U
+			deltaDistRouteU += params.timeCost[move.U->prev->cour][V->cour] + params.timeCost[V->cour][move.U->next->cour] - params.timeCost[move.U->prev->cour][move.U->next->cour];
+		else
+			deltaDistRouteU += deltaInsertion(V, move.bestPositionV);
+	}
+
+	return deltaDistRouteU + deltaDistRouteV
+		+ penaltyExcessLoad(routeU->load + demandV - demandU) - routeU->penalty
+		+ penaltyExcessLoad(routeV->load + demandU - demandV) - routeV->penalty
+		+ penaltyExcessDuration(routeU->duration + deltaDistRouteU + serviceDurationV - serviceDurationU)
+		+ penaltyExcessDuration(routeV->duration + deltaDistRouteV + serviceDurationU - serviceDurationV);
+}
+
 double LocalSearch::getCheapestInsertSimultRemoval(Node * U, Node * V, Node *& bestPosition)
 {
-	ThreeBestInsert * myBestInsert = &bestInsertClient[V->route->cour][U->cour];
+	ThreeBestInsert * myBestInsert = U->bestInsert;
 	bool found = false;
 
 	// Find best insertion in the route such that V is not next or pred (can only belong to the top three locations)
-	bestPosition = myBestInsert->bestLocation[0];
-	double bestCost = myBestInsert->bestCost[0];
+	// The approximate costs kept in memory are sufficient to compare the moves, the selected move is evaluated exactly in swapStar()
+	int bestIndex = 0;
+	bestPosition = getLocation(myBestInsert->bestLocation[0], V->route);
 	found = (bestPosition != V && bestPosition->next != V);
-	if (!found && myBestInsert->bestLocation[1] != NULL)
+	if (!found && myBestInsert->bestLocation[1] != -1)
 	{
-		bestPosition = myBestInsert->bestLocation[1];
-		bestCost = myBestInsert->bestCost[1];
+		bestIndex = 1;
+		bestPosition = getLocation(myBestInsert->bestLocation[1], V->route);
 		found = (bestPosition != V && bestPosition->next != V);
-		if (!found && myBestInsert->bestLocation[2] != NULL)
+		if (!found && myBestInsert->bestLocation[2] != -1)
 		{
-			bestPosition = myBestInsert->bestLocation[2];
-			bestCost = myBestInsert->bestCost[2];
+			bestIndex = 2;
+			bestPosition = getLocation(myBestInsert->bestLocation[2], V->route);
 			found = true;
 		}
 	}
+	double bestCost = myBestInsert->bestCost[bestIndex];
 
 	// Compute insertion in the place of V
 	double deltaCost = params.timeCost[V->prev->cour][U->cour] + params.timeCost[U->cour][V->next->cour] - params.timeCost[V->prev->cour][V->next->cour];
@@ -606,23 +920,86 @@ double LocalSearch::getCheapestInsertSimultRemoval(Node * U, Node * V, Node *& b
 
 void LocalSearch::preprocessInsertions(Route * R1, Route * R2)
 {
+	int oldestCalculation = INT_MAX;
 	for (Node * U = R1->depot->next; !U->isDepot; U = U->next)
 	{
-		// Performs the preprocessing
 		U->deltaRemoval = params.timeCost[U->prev->cour][U->next->cour] - params.timeCost[U->prev->cour][U->cour] - params.timeCost[U->cour][U->next->cour];
-		if (R2->whenLastModified > bestInsertClient[R2->cour][U->cour].whenLastCalculated)
+		U->bestInsert = getBestInsert(U, R2);
+		if (R2->whenLastModified > U->bestInsert->whenLastCalculated)
+			oldestCalculation = std::min<int>(oldestCalculation, U->bestInsert->whenLastCalculated);
+	}
+	if (oldestCalculation == INT_MAX) return;
+
+	// Listing the edges of R2 which have been created since the oldest calculation (all other edges of R2 have already been evaluated)
+	modifiedEdges.clear();
+	Node * myNode = R2->depot;
+	do
+	{
+		if (myNode->whenLastModifiedEdge > oldestCalculation) modifiedEdges.push_back(myNode);
+		myNode = myNode->next;
+	} while (!myNode->isDepot);
+
+	for (Node * U = R1->depot->next; !U->isDepot; U = U->next)
+	{
+		ThreeBestInsert & myBestInsert = *U->bestInsert;
+		if (R2->whenLastModified > myBestInsert.whenLastCalculated)
 		{
-			bestInsertClient[R2->cour][U->cour].reset();
-			bestInsertClient[R2->cour][U->cour].whenLastCalculated = nbMoves;
-			bestInsertClient[R2->cour][U->cour].bestCost[0] = params.timeCost[0][U->cour] + params.timeCost[U->cour][R2->depot->next->cour] - params.timeCost[0][R2->depot->next->cour];
-			bestInsertClient[R2->cour][U->cour].bestLocation[0] = R2->depot;
-			for (Node * V = R2->depot->next; !V->isDepot; V = V->next)
+			if (isStillValid(myBestInsert, U, R2))
 			{
-				double deltaCost = params.timeCost[V->cour][U->cour] + params.timeCost[U->cour][V->next->cour] - params.timeCost[V->cour][V->next->cour];
-				bestInsertClient[R2->cour][U->cour].compareAndAdd(deltaCost, V);
+				// The three best positions are still in place, so only the new edges can lead to better insertions
+				for (Node * V : modifiedEdges)
+				{
+					if (V->whenLastModifiedEdge > myBestInsert.whenLastCalculated
+						&& V->cour != myBestInsert.bestLocation[0] && V->cour != myBestInsert.bestLocation[1] && V->cour != myBestInsert.bestLocation[2])
+						myBestInsert.compareAndAdd((float)deltaInsertion(U, V), V->cour);
+				}
 			}
+			else
+			{
+				// Otherwise performs the complete preprocessing
+				myBestInsert.reset();
+				myBestInsert.bestCost[0] = (float)deltaInsertion(U, R2->depot);
+				myBestInsert.bestLocation[0] = 0;
+				for (Node * V = R2->depot->next; !V->isDepot; V = V->next)
+					myBestInsert.compareAndAdd((float)deltaInsertion(U, V), V->cour);
+			}
+			myBestInsert.whenLastCalculated = nbMoves;
+		}
+	}
+}
+
+bool LocalSearch::isStillValid(const ThreeBestInsert & myBestInsert, Node * U, Route * R2)
+{
+	if (myBestInsert.whenLastCalculated < 0) return false;
+	for (int i = 0; i < 3 && myBestInsert.bestLocation[i] != -1; i++)
+	{
+		Node * V = getLocation(myBestInsert.bestLocation[i], R2);
+		if (V->route != R2 || (float)deltaInsertion(U, V) != myBestInsert.bestCost[i])
+			return false;
+	}
+	return true;
+}
+
+ThreeBestInsert * LocalSearch::getBestInsert(Node * U, Route * R2)
+{
+	std::vector < ThreeBestInsert > & bestInsertRow = bestInsertClient[R2->cour];
+	if (bestInsertRow.empty())
+	{
+		// First evaluation of SWAP* in this route: its row is a released one if possible (whose slots belong to previous solutions), or a new one
+		if (freeBestInsertRows.empty()) bestInsertRow.resize(params.nbClients + 1);
+		else
+		{
+			bestInsertRow.swap(freeBestInsertRows.back());
+			freeBestInsertRows.pop_back();
 		}
 	}
+	ThreeBestInsert * myBestInsert = &bestInsertRow[U->cour];
+	if (myBestInsert->epoch != epoch) // Memory of a previous solution
+	{
+		myBestInsert->epoch = epoch;
+		myBestInsert->whenLastCalculated = -1;
+	}
+	return myBestInsert;
 }
 
 void LocalSearch::insertNode(Node * U, Node * V)
@@ -659,23 +1036,44 @@ void LocalSearch::swapNode(Node * U, Node * V)
 	V->route = myRouteU;
 }
 
-void LocalSearch::updateRouteData(Route * myRoute)
+void LocalSearch::updateRouteData(Route * myRoute, Node * firstModified, Node * lastModified)
 {
-	int myplace = 0;
-	double myload = 0.;
-	double mytime = 0.;
-	double myReversalDistance = 0.;
-	double cumulatedX = 0.;
-	double cumulatedY = 0.;
+	// The data of firstModified and of the nodes preceding it in the route is still valid, only the subsequent nodes are updated
+	Node * mynode = firstModified;
+	if (mynode->isDepot)
+	{
+		mynode->position = 0;
+		mynode->cumulatedLoad = 0.;
+		mynode->cumulatedTime = 0.;
+		mynode->cumulatedReversalDistance = 0.;
+		mynode->cumulatedX = 0.;
+		mynode->cumulatedY = 0.;
+		if (mynode->lastNext != mynode->next)
+		{
+			mynode->whenLastModifiedEdge = nbMoves;
+			mynode->lastNext = mynode->next;
+			activateNeighborhood(mynode->next);
+		}
+	}
+	else if (mynode->lastNext != mynode->next || mynode->lastRoute != myRoute)
+	{
+		mynode->whenLastModifiedEdge = nbMoves;
+		mynode->lastNext = mynode->next;
+		mynode->lastRoute = myRoute;
+		activateNeighborhood(mynode);
+		activateNeighborhood(mynode->next);
+	}
 
-	Node * mynode = myRoute->depot;
-	mynode->position = 0;
-	mynode->cumulatedLoad = 0.;
-	mynode->cumulatedTime = 0.;
-	mynode->cumulatedReversalDistance = 0.;
+	int myplace = mynode->position;
+	double myload = mynode->cumulatedLoad;
+	double mytime = mynode->cumulatedTime;
+	double myReversalDistance = mynode->cumulatedReversalDistance;
+	double cumulatedX = mynode->cumulatedX;
+	double cumulatedY = mynode->cumulatedY;
+	double oldTimeLastModified = (lastModified != NULL) ? lastModified->cumulatedTime : 0.;
+	double oldReversalLastModified = (lastModified != NULL) ? lastModified->cumulatedReversalDistance : 0.;
 
-	bool firstIt = true;
-	while (!mynode->isDepot || firstIt)
+	do
 	{
 		mynode = mynode->next;
 		myplace++;
@@ -688,80 +1086,139 @@ void LocalSearch::updateRouteData(Route * myRoute)
 		mynode->cumulatedReversalDistance = myReversalDistance;
 		if (!mynode->isDepot)
 		{
+			if (mynode->lastNext != mynode->next || mynode->lastRoute != myRoute)
+			{
+				mynode->whenLastModifiedEdge = nbMoves;
+				mynode->lastNext = mynode->next;
+				mynode->lastRoute = myRoute;
+				activateNeighborhood(mynode);
+				activateNeighborhood(mynode->next);
+			}
 			cumulatedX += params.cli[mynode->cour].coordX;
 			cumulatedY += params.cli[mynode->cour].coordY;
-			if (firstIt) myRoute->sector.initialize(params.cli[mynode->cour].polarAngle);
-			else myRoute->sector.extend(params.cli[mynode->cour].polarAngle);
+			mynode->cumulatedX = cumulatedX;
+			mynode->cumulatedY = cumulatedY;
+			if (mynode->prev->isDepot) mynode->cumulatedSector.initialize(params.cli[mynode->cour].polarAngle);
+			else
+			{
+				mynode->cumulatedSector = mynode->prev->cumulatedSector;
+				mynode->cumulatedSector.extend(params.cli[mynode->cour].polarAngle);
+			}
 		}
-		firstIt = false;
 	}
+	while (!mynode->isDepot && mynode != lastModified);
 
+	if (!mynode->isDepot)
+	{
+		// Intra-route move: the rest of the route visits the same customers in the same order, only the cumulated time and reversal distance are shifted
+		double shiftTime = mytime - oldTimeLastModified;
+		double shiftReversalDistance = myReversalDistance - oldReversalLastModified;
+		do
+		{
+			mynode = mynode->next;
+			mynode->cumulatedTime += shiftTime;
+			mynode->cumulatedReversalDistance += shiftReversalDistance;
+		}
+		while (!mynode->isDepot);
+		myplace = mynode->position;
+		myload = mynode->cumulatedLoad;
+		mytime = mynode->cumulatedTime;
+		myReversalDistance = mynode->cumulatedReversalDistance;
+	}
+
+	// A change of the load or duration excess of the route changes the evaluation of the moves of all its customers, not only of the ones close to the modified edges
+	double oldPenalty = myRoute->penalty;
 	myRoute->duration = mytime;
 	myRoute->load = myload;
 	myRoute->penalty = penaltyExcessDuration(mytime) + penaltyExcessLoad(myload);
+	if (myRoute->penalty != oldPenalty)
+		for (Node * myClient = myRoute->depot->next; !myClient->isDepot; myClient = myClient->next)
+			activateNode(myClient->cour);
 	myRoute->nbCustomers = myplace-1;
 	myRoute->reversalDistance = myReversalDistance;
 	// Remember "when" this route has been last modified (will be used to filter unnecessary move evaluations)
 	myRoute->whenLastModified = nbMoves ;
 
+	// The set of customers of the route (hence its barycenter and circle sector) does not change in intra-route moves
+	if (lastModified != NULL) return;
+
+	std::vector < int >::iterator itEmpty = std::lower_bound(emptyRoutes.begin(), emptyRoutes.end(), myRoute->cour);
+	bool wasEmpty = (itEmpty != emptyRoutes.end() && *itEmpty == myRoute->cour);
 	if (myRoute->nbCustomers == 0)
 	{
 		myRoute->polarAngleBarycenter = 1.e30;
-		emptyRoutes.insert(myRoute->cour);
+		if (!wasEmpty) emptyRoutes.insert(itEmpty, myRoute->cour);
+		sectorIndex.remove(myRoute->cour);
 	}
 	else
 	{
 		myRoute->polarAngleBarycenter = atan2(cumulatedY/(double)myRoute->nbCustomers - params.cli[0].coordY, cumulatedX/(double)myRoute->nbCustomers - params.cli[0].coordX);
-		emptyRoutes.erase(myRoute->cour);
+		myRoute->sector = mynode->prev->cumulatedSector;
+		if (wasEmpty) emptyRoutes.erase(itEmpty);
+		sectorIndex.update(myRoute->cour, myRoute->sector);
 	}
 }
 
+void LocalSearch::activateNode(int i)
+{
+	if (clients[i].isActive) return;
+	clients[i].isActive = true;
+	activeNodes.push_back(i);
+}
+
+void LocalSearch::activateNeighborhood(Node * U)
+{
+	if (U->isDepot) return;
+	activateNode(U->cour);
+	for (int v : params.correlatedVertices[U->cour]) activateNode(v);
+}
+
 void LocalSearch::loadIndividual(const Individual & indiv)
+{
+	loadRoutes(indiv.chromT, indiv.routeStarts, orderRoutes); // orderRoutes contains all route indices
+}
+
+void LocalSearch::loadRoutes(const std::vector <int> & chromT, const std::vector <int> & routeStarts, const std::vector <int> & routeIndices)
 {
 	emptyRoutes.clear();
 	nbMoves = 0; 
-	for (int r = 0; r < params.nbVehicles; r++)
+	epoch++; // Invalidates the SWAP* insertion memory of the previous solution
+	nbLoads++; // Customers which are not loaded now are left out of the search
+	activeNodes.clear();
+	for (int r : routeIndices) // Before loading the routes, since loading a route activates customers of the other routes
+		for (int pos = routeStarts[r]; pos < routeStarts[r + 1]; pos++) clients[chromT[pos]].isActive = false;
+	for (int r : routeIndices) loadRoute(r, chromT.data() + routeStarts[r], routeStarts[r + 1] - routeStarts[r]);
+}
+
+void LocalSearch::loadRoute(int r, const int * sequence, int nbCustomers)
+{
+	Node * myDepot = &depots[r];
+	Node * myDepotFin = &depotsEnd[r];
+	Route * myRoute = &routes[r];
+	myDepot->lastNext = NULL;
+	myDepot->prev = myDepotFin;
+	myDepotFin->next = myDepot;
+	Node * myClient = myDepot;
+	for (int i = 0; i < nbCustomers; i++)
 	{
-		Node * myDepot = &depots[r];
-		Node * myDepotFin = &depotsEnd[r];
-		Route * myRoute = &routes[r];
-		myDepot->prev = myDepotFin;
-		myDepotFin->next = myDepot;
-		if (!indiv.chromR[r].empty())
-		{
-			Node * myClient = &clients[indiv.chromR[r][0]];
-			myClient->route = myRoute;
-			myClient->prev = myDepot;
-			myDepot->next = myClient;
-			for (int i = 1; i < (int)indiv.chromR[r].size(); i++)
-			{
-				Node * myClientPred = myClient;
-				myClient = &clients[indiv.chromR[r][i]]; 
-				myClient->prev = myClientPred;
-				myClientPred->next = myClient;
-				myClient->route = myRoute;
-			}
-			myClient->next = myDepotFin;
-			myDepotFin->prev = myClient;
-		}
-		else
-		{
-			myDepot->next = myDepotFin;
-			myDepotFin->prev = myDepot;
-		}
-		updateRouteData(&routes[r]);
-		routes[r].whenLastTestedSWAPStar = -1;
-		for (int i = 1; i <= params.nbClients; i++) // Initializing memory structures
-			bestInsertClient[r][i].whenLastCalculated = -1;
+		Node * myClientPred = myClient;
+		myClient = &clients[sequence[i]];
+		myClient->prev = myClientPred;
+		myClientPred->next = myClient;
+		myClient->route = myRoute;
+		myClient->whenLastTestedRI = -1; // Initializing memory structures
+		myClient->lastRoute = NULL;
+		myClient->whenLoaded = nbLoads;
 	}
-
-	for (int i = 1; i <= params.nbClients; i++) // Initializing memory structures
-		clients[i].whenLastTestedRI = -1;
+	myClient->next = myDepotFin;
+	myDepotFin->prev = myClient;
+	updateRouteData(myRoute, myDepot, NULL);
+	myRoute->whenLastTestedSWAPStar = -1;
 }
 
 void LocalSearch::exportIndividual(Individual & indiv)
 {
-	std::vector < std::pair <double, int> > routePolarAngles ;
+	routePolarAngles.clear();
 	for (int r = 0; r < params.nbVehicles; r++)
 		routePolarAngles.push_back(std::pair <double, int>(routes[r].polarAngleBarycenter, r));
 	std::sort(routePolarAngles.begin(), routePolarAngles.end()); // empty routes have a polar angle of 1.e30, and therefore will always appear at the end
@@ -769,32 +1226,164 @@ void LocalSearch::exportIndividual(Individual & indiv)
 	int pos = 0;
 	for (int r = 0; r < params.nbVehicles; r++)
 	{
-		indiv.chromR[r].clear();
+		indiv.routeStarts[r] = pos;
 		Node * node = depots[routePolarAngles[r].second].next;
 		while (!node->isDepot)
 		{
 			indiv.chromT[pos] = node->cour;
-			indiv.chromR[r].push_back(node->cour);
 			node = node->next;
 			pos++;
 		}
 	}
+	indiv.routeStarts[params.nbVehicles] = pos;
 
 	indiv.evaluateCompleteCost(params);
 }
 
-LocalSearch::LocalSearch(Params & params) : params (params)
+void LocalSearch::addMoveStatistics(Statistics & stats) const
+{
+	stats.nbLoopsLS += nbLoops;
+	for (int k = 0; k < NB_MOVE_TYPES; k++)
+	{
+		stats.nbMoveEvaluations[k] += nbMoveEvaluations[k];
+		stats.nbMoveSuccesses[k] += nbMoveSuccesses[k];
+	}
+	for (const LocalSearch & worker : workers) worker.addMoveStatistics(stats);
+}
+
+void LocalSearch::checkInsertionMemory()
+{
+	for (Route & R1 : routes)
+	{
+		if (R1.nbCustomers == 0) continue;
+		for (Route & R2 : routes)
+		{
+			if (&R2 == &R1 || R2.nbCustomers == 0) continue;
+			preprocessInsertions(&R1, &R2);
+			for (Node * U = R1.depot->next; !U->isDepot; U = U->next)
+			{
+				// Three best insertion costs of U in R2, evaluating all positions
+				ThreeBestInsert reference;
+				Node * V = R2.depot;
+				do
+				{
+					reference.compareAndAdd((float)deltaInsertion(U, V), V->cour);
+					V = V->next;
+				} while (!V->isDepot);
+
+				std::string context = "insertion memory of client " + std::to_string(U->cour) + " in route " + std::to_string(R2.cour);
+				for (int i = 0; i < 3; i++)
+				{
+					if (U->bestInsert->bestCost[i] != reference.bestCost[i])
+						throw std::string("Incorrect " + context + ": cost " + std::to_string(U->bestInsert->bestCost[i]) + " instead of " + std::to_string(reference.bestCost[i]));
+					if (U->bestInsert->bestLocation[i] == -1) continue;
+					Node * location = getLocation(U->bestInsert->bestLocation[i], &R2);
+					if (location->route != &R2 || (float)deltaInsertion(U, location) != U->bestInsert->bestCost[i])
+						throw std::string("Incorrect " + context + ": position not matching its cost");
+				}
+			}
+		}
+	}
+}
+
+void LocalSearch::checkRouteData()
+{
+	// The cumulated values of the tail of a route are shifted rather than recalculated after intra-route moves, hence a small tolerance
+	auto checkValue = [](double value, double reference, const std::string & context)
+	{
+		if (std::fabs(value - reference) > 1.e-9 * std::max<double>(1., std::fabs(reference)))
+			throw std::string("Incorrect " + context + ": " + std::to_string(value) + " instead of " + std::to_string(reference));
+	};
+
+	for (Route & myRoute : routes)
+	{
+		std::string context = " of route " + std::to_string(myRoute.cour);
+		std::vector <int> polarAngles;
+		double load = 0.;
+		double time = 0.;
+		double reversalDistance = 0.;
+		double cumulatedX = 0.;
+		double cumulatedY = 0.;
+		Node * myNode = myRoute.depot;
+		do
+		{
+			myNode = myNode->next;
+			load += params.cli[myNode->cour].demand;
+			time += params.timeCost[myNode->prev->cour][myNode->cour] + params.cli[myNode->cour].serviceDuration;
+			reversalDistance += params.timeCost[myNode->cour][myNode->prev->cour] - params.timeCost[myNode->prev->cour][myNode->cour];
+			std::string contextNode = (myNode->isDepot ? " of the end depot" : " of client " + std::to_string(myNode->cour)) + context;
+			if (myNode->route != &myRoute || myNode->prev->next != myNode) throw std::string("Incorrect links" + contextNode);
+			if (myNode->position != (int)polarAngles.size() + 1) throw std::string("Incorrect position" + contextNode);
+			checkValue(myNode->cumulatedLoad, load, "cumulated load" + contextNode);
+			checkValue(myNode->cumulatedTime, time, "cumulated time" + contextNode);
+			checkValue(myNode->cumulatedReversalDistance, reversalDistance, "cumulated reversal distance" + contextNode);
+			if (myNode->isDepot) break;
+			cumulatedX += params.cli[myNode->cour].coordX;
+			cumulatedY += params.cli[myNode->cour].coordY;
+			checkValue(myNode->cumulatedX, cumulatedX, "cumulated X" + contextNode);
+			checkValue(myNode->cumulatedY, cumulatedY, "cumulated Y" + contextNode);
+			polarAngles.push_back(params.cli[myNode->cour].polarAngle);
+			for (int angle : polarAngles)
+				if (!myNode->cumulatedSector.isEnclosed(angle)) throw std::string("Cumulated circle sector" + contextNode + " not enclosing the previous clients");
+		} while (true);
+
+		if (myRoute.nbCustomers != (int)polarAngles.size()) throw std::string("Incorrect number of clients" + context);
+		checkValue(myRoute.load, load, "load" + context);
+		checkValue(myRoute.duration, time, "duration" + context);
+		checkValue(myRoute.reversalDistance, reversalDistance, "reversal distance" + context);
+		checkValue(myRoute.penalty, penaltyExcessDuration(time) + penaltyExcessLoad(load), "penalty" + context);
+		bool isListedEmpty = std::binary_search(emptyRoutes.begin(), emptyRoutes.end(), myRoute.cour);
+		bool isIndexed = (sectorIndex.position[myRoute.cour] != -1);
+		if (isListedEmpty != (myRoute.nbCustomers == 0) || isIndexed == (myRoute.nbCustomers == 0)) throw std::string("Incorrect list of empty routes or index of sectors" + context);
+		if (myRoute.nbCustomers == 0) continue;
+		checkValue(myRoute.polarAngleBarycenter, atan2(cumulatedY / (double)myRoute.nbCustomers - params.cli[0].coordY, cumulatedX / (double)myRoute.nbCustomers - params.cli[0].coordX), "polar angle of the barycenter" + context);
+		for (int angle : polarAngles)
+			if (!myRoute.sector.isEnclosed(angle)) throw std::string("Circle sector" + context + " not enclosing its clients");
+		if (sectorIndex.sectors[myRoute.cour].start != myRoute.sector.start || sectorIndex.sectors[myRoute.cour].end != myRoute.sector.end)
+			throw std::string("Circle sector" + context + " differing from the index of sectors");
+	}
+	if (!std::is_sorted(emptyRoutes.begin(), emptyRoutes.end())) throw std::string("Unsorted list of empty routes");
+}
+
+LocalSearch::LocalSearch(Params & params) : LocalSearch(params, params.ran, params.traceBuffers[0])
+{
+	// Workers of the parallel search and their threads, which wait for the parallel searches until the destruction of the local search
+	if (params.ap.nbThreadsLS > 1)
+	{
+		workerRans = std::vector < std::minstd_rand >(params.ap.nbThreadsLS);
+		for (int w = 0; w < params.ap.nbThreadsLS; w++) workers.emplace_back(params, workerRans[w], params.traceBuffers[w]);
+		groupOfRoute = std::vector <int>(params.nbVehicles);
+		groupChromT = std::vector <int>(params.nbClients);
+		groupRouteStarts = std::vector <int>(params.nbVehicles + 1);
+		for (int w = 1; w < params.ap.nbThreadsLS; w++) workerThreads.push_back(std::thread(&LocalSearch::runWorkerThread, this, w));
+	}
+}
+
+LocalSearch::LocalSearch(Params & params, std::minstd_rand & ran, TraceBuffer & traceBuffer) : params (params), ran (ran), traceBuffer (traceBuffer)
 {
 	clients = std::vector < Node >(params.nbClients + 1);
 	routes = std::vector < Route >(params.nbVehicles);
 	depots = std::vector < Node >(params.nbVehicles);
 	depotsEnd = std::vector < Node >(params.nbVehicles);
-	bestInsertClient = std::vector < std::vector <ThreeBestInsert> >(params.nbVehicles, std::vector <ThreeBestInsert>(params.nbClients + 1));
+	bestInsertClient = std::vector < std::vector < ThreeBestInsert > >(params.nbVehicles);
+	epoch = 0;
+	nbLoads = 0;
+	nbParallelSearches = 0;
+	nbThreadsRunning = 0;
+	areThreadsStopping = false;
+	groupSolution = NULL;
+	nbCalls = 0;
+	nbInterruptions = 0;
+	nbLoops = 0;
+	std::fill(nbMoveEvaluations, nbMoveEvaluations + NB_MOVE_TYPES, 0);
+	std::fill(nbMoveSuccesses, nbMoveSuccesses + NB_MOVE_TYPES, 0);
+	startSearch(0);
 
 	for (int i = 0; i <= params.nbClients; i++) 
 	{ 
 		clients[i].cour = i; 
 		clients[i].isDepot = false; 
+		clients[i].whenLoaded = -1;
 	}
 	for (int i = 0; i < params.nbVehicles; i++)
 	{
@@ -809,5 +1398,17 @@ LocalSearch::LocalSearch(Params & params) : params (params)
 	}
 	for (int i = 1 ; i <= params.nbClients ; i++) orderNodes.push_back(i);
 	for (int r = 0 ; r < params.nbVehicles ; r++) orderRoutes.push_back(r);
+	emptyRoutes.reserve(params.nbVehicles);
+	routePolarAngles.reserve(params.nbVehicles);
+	sectorIndex.initialize(params.nbVehicles);
 }
 
+LocalSearch::~LocalSearch()
+{
+	{
+		std::lock_guard < std::mutex > lock(workerMutex);
+		areThreadsStopping = true;
+	}
+	workerStart.notify_all();
+	for (std::thread & workerThread : workerThreads) workerThread.join();
+}
@@ -24,8 +24,13 @@ SOFTWARE.*/
 #define LOCALSEARCH_H
 
 #include "Individual.h"
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 struct Node ;
+struct ThreeBestInsert ;
 
 // Structure containing a route
 struct Route
@@ -49,23 +54,34 @@ struct Node
 	int cour;							// Node index
 	int position;						// Position in the route
 	int whenLastTestedRI;				// "When" the RI moves for this node have been last tested
+	int whenLoaded;						// Number of the loading in which this node has last been loaded. It belongs to the current solution of the search only if this is the last loading
+	bool isActive;						// Tells whether the node is in the list of nodes to explore in the next RI loop
 	Node * next;						// Next node in the route order
 	Node * prev;						// Previous node in the route order
 	Route * route;						// Pointer towards the associated route
 	double cumulatedLoad;				// Cumulated load on this route until the customer (including itself)
 	double cumulatedTime;				// Cumulated time on this route until the customer (including itself)
 	double cumulatedReversalDistance;	// Difference of cost if the segment of route (0...cour) is reversed (useful for 2-opt moves with asymmetric problems)
+	double cumulatedX;					// Sum of the X coordinates of the customers on this route until the customer (including itself)
+	double cumulatedY;					// Sum of the Y coordinates of the customers on this route until the customer (including itself)
+	CircleSector cumulatedSector;		// Circle sector of the customers on this route until the customer (including itself)
 	double deltaRemoval;				// Difference of cost in the current route if the node is removed (used in SWAP*)
+	int whenLastModifiedEdge;			// "When" the edge (this,next) has been last created in the current route (used to incrementally update the SWAP* insertion costs)
+	Node * lastNext;					// Successor of the node observed during the last update of the route data
+	Route * lastRoute;					// Route of the node observed during the last update of the route data
+	ThreeBestInsert * bestInsert;		// (SWAP*) Three best insertion positions of the node in the route currently considered
 };
 
 // Structure used in SWAP* to remember the three best insertion positions of a customer in a given route
+// Kept compact (single-precision costs and node indices), since such a structure is stored for each customer and each route in which SWAP* has been evaluated
 struct ThreeBestInsert
 {
+	int epoch;					// Index of the loaded solution for which this structure has been calculated
 	int whenLastCalculated;
-	double bestCost[3];
-	Node * bestLocation[3];
+	float bestCost[3];
+	int bestLocation[3];		// Index of the node after which the insertion takes place (0 for the depot, -1 if none)
 
-	void compareAndAdd(double costInsert, Node * placeInsert)
+	void compareAndAdd(float costInsert, int placeInsert)
 	{
 		if (costInsert >= bestCost[2]) return;
 		else if (costInsert >= bestCost[1])
@@ -88,12 +104,12 @@ struct ThreeBestInsert
 	// Resets the structure (no insertion calculated)
 	void reset()
 	{
-		bestCost[0] = 1.e30; bestLocation[0] = NULL;
-		bestCost[1] = 1.e30; bestLocation[1] = NULL;
-		bestCost[2] = 1.e30; bestLocation[2] = NULL;
+		bestCost[0] = 1.e30f; bestLocation[0] = -1;
+		bestCost[1] = 1.e30f; bestLocation[1] = -1;
+		bestCost[2] = 1.e30f; bestLocation[2] = -1;
 	}
 
-	ThreeBestInsert() { reset(); };
+	ThreeBestInsert() : epoch(-1), whenLastCalculated(-1) { reset(); };
 };
 
 // Structured used to keep track of the best SWAP* move
@@ -113,19 +129,51 @@ class LocalSearch
 private:
 	
 	Params & params ;							// Problem parameters
+	std::minstd_rand & ran;						// Random number generator (the one of params, except for the workers of the parallel search which have their own)
+	TraceBuffer & traceBuffer;					// Trace buffer of the thread running this local search (see Params::traceBuffers)
 	bool searchCompleted;						// Tells whether all moves have been evaluated without success
 	int nbMoves;								// Total number of moves (RI and SWAP*) applied during the local search. Attention: this is not only a simple counter, it is also used to avoid repeating move evaluations
 	std::vector < int > orderNodes;				// Randomized order for checking the nodes in the RI local search
+	std::vector < int > activeNodes;			// Nodes close to the modifications applied since the beginning of the current RI loop, to be explored in the next loop
+	std::vector < int > nodesToExplore;			// Nodes explored in the current RI loop (after the first two loops)
 	std::vector < int > orderRoutes;			// Randomized order for checking the routes in the SWAP* local search
-	std::set < int > emptyRoutes;				// indices of all empty routes
+	std::vector < int > emptyRoutes;			// indices of all empty routes, in increasing order (reserved to nbVehicles, hence never reallocated)
+	CircleSectorIndex sectorIndex;				// (SWAP*) Circle sectors of all non-empty routes, ordered by start angle
+	std::vector < int > overlappingRoutes;		// (SWAP*) Temporary list of the routes whose circle sectors overlap the one of routeU
 	int loopID;									// Current loop index
+	int epoch;									// Number of solutions loaded so far, used to invalidate the SWAP* insertion memory without resetting it
+	int nbLoads;								// Number of loadings of routes so far (see Node::whenLoaded)
+	int posNodeLoop;							// Position of the next node to explore in the RI moves of the current loop, or -1 if this loop has not started yet (allows to resume an interrupted search)
+	int posRouteLoop;							// Position of the next route to explore in the SWAP* moves of the current loop
+	int nbMovesStartCall;						// Value of nbMoves at the start of the current call, used for the move budget
+	clock_t clockStartCall;						// Time at the start of the current call, used for the time budget
+	int nbBudgetChecks;							// Number of budget checks during the current call (the clock is only queried once every 64 checks)
+
+	/* PARALLEL SEARCH OVER GROUPS OF ROUTES (params.ap.nbThreadsLS > 1) */
+	std::deque < LocalSearch > workers;			// One local search structure per group of routes, holding only the routes of its group
+	std::vector < std::minstd_rand > workerRans;	// Random number generators of the workers
+	std::vector < std::thread > workerThreads;	// Threads of the workers 1 to nbThreadsLS-1, created once with the local search (worker 0 runs in the calling thread)
+	std::mutex workerMutex;						// Protects the synchronization variables below
+	std::condition_variable workerStart;		// Notified when a parallel search starts or when the threads must stop
+	std::condition_variable workerEnd;			// Notified when the last thread finishes its group
+	int nbParallelSearches;						// Number of parallel searches started so far (each thread waits until it increases)
+	int nbThreadsRunning;						// Number of threads still improving their group in the current parallel search
+	bool areThreadsStopping;					// Tells the threads to stop (destruction of the local search)
+	const Individual * groupSolution;			// Solution whose groups are improved by the current parallel search
+	std::vector < int > routeGroup;				// (Worker) Indices of the routes of the group handled by this worker
+	std::vector < int > groupOfRoute;			// Index of the worker handling each route in the current parallel search
+	std::vector < int > groupChromT;			// Routes improved by the workers, as a giant tour ...
+	std::vector < int > groupRouteStarts;		// ... and the position of the first customer of each route in it
 
 	/* THE SOLUTION IS REPRESENTED AS A LINKED LIST OF ELEMENTS */
 	std::vector < Node > clients;				// Elements representing clients (clients[0] is a sentinel and should not be accessed)
 	std::vector < Node > depots;				// Elements representing depots
 	std::vector < Node > depotsEnd;				// Duplicate of the depots to mark the end of the routes
 	std::vector < Route > routes;				// Elements representing routes
-	std::vector < std::vector < ThreeBestInsert > > bestInsertClient;   // (SWAP*) For each route and node, storing the cheapest insertion cost 
+	std::vector < std::vector < ThreeBestInsert > > bestInsertClient;	// (SWAP*) For each route, cheapest insertion costs of each node in this route (one fixed slot per node). The row of a route is only allocated when SWAP* first evaluates insertions in it
+	std::vector < std::vector < ThreeBestInsert > > freeBestInsertRows;	// (Worker) Rows released by the routes which left the group of this worker, reused by the next routes of its group
+	std::vector < Node * > modifiedEdges;		// (SWAP*) Temporary list of the edges of a route created since the last insertion cost calculations
+	std::vector < std::pair <double, int> > routePolarAngles;	// Temporary list of the routes ordered by polar angle of their barycenters
 
 	/* TEMPORARY VARIABLES USED IN THE LOCAL SEARCH LOOPS */
 	// nodeUPrev -> nodeU -> nodeX -> nodeXNext
@@ -148,6 +196,7 @@ private:
 
 	inline double penaltyExcessDuration(double myDuration) {return std::max<double>(0., myDuration - params.durationLimit)*penaltyDurationLS;}
 	inline double penaltyExcessLoad(double myLoad) {return std::max<double>(0., myLoad - params.vehicleCapacity)*penaltyCapacityLS;}
+	inline double deltaInsertion(Node * U, Node * V) {return params.timeCost[V->cour][U->cour] + params.timeCost[U->cour][V->next->cour] - params.timeCost[V->cour][V->next->cour];} // Distance increase when inserting U after V
 
 	/* RELOCATE MOVES */
 	// (Legacy notations: move1...move9 from Prins 2004)
@@ -168,26 +217,99 @@ private:
 	/* SUB-ROUTINES FOR EFFICIENT SWAP* EVALUATIONS */
 	bool swapStar(); // Calculates all SWAP* between routeU and routeV and apply the best improving move
 	double getCheapestInsertSimultRemoval(Node * U, Node * V, Node *& bestPosition); // Calculates the insertion cost and position in the route of V, where V is omitted
+	double getSwapStarCost(const SwapStarElement & move); // Calculates the cost of a SWAP* (or relocate) move in double precision
 	void preprocessInsertions(Route * R1, Route * R2); // Preprocess all insertion costs of nodes of route R1 in route R2
+	bool isStillValid(const ThreeBestInsert & myBestInsert, Node * U, Route * R2); // Tells whether the three best insertion positions of U in R2 still exist with the same costs
+	ThreeBestInsert * getBestInsert(Node * U, Route * R2); // Accesses the insertion memory of U in R2 (invalidated if it belongs to a previous solution)
+	inline Node * getLocation(int location, Route * R2) {return (location == 0) ? R2->depot : &clients[location];} // Node after which an insertion takes place in R2
 
 	/* ROUTINES TO UPDATE THE SOLUTIONS */
 	static void insertNode(Node * U, Node * V);		// Solution update: Insert U after V
 	static void swapNode(Node * U, Node * V) ;		// Solution update: Swap U and V							   
-	void updateRouteData(Route * myRoute);			// Updates the preprocessed data of a route
+	void updateRouteData(Route * myRoute, Node * firstModified, Node * lastModified);	// Updates the preprocessed data of a route, starting after firstModified (first node whose successor has changed). For intra-route moves, lastModified is the last node whose predecessor has changed (NULL otherwise)
+	static inline Node * firstInRoute(Node * A, Node * B) {return (A->position <= B->position) ? A : B;} // Node with the lowest position among two nodes of the same route
+	static inline Node * lastInRoute(Node * A, Node * B) {return (A->position >= B->position) ? A : B;} // Node with the highest position among two nodes of the same route
+	void activateNeighborhood(Node * U);			// Adds U and its correlated vertices to the nodes to explore in the next RI loop
+	void activateNode(int i);						// Adds client i to the nodes to explore in the next RI loop, unless it is already listed
+
+	// Splits the routes of the current solution into groups of neighboring routes (in terms of polar angles), improves each group in parallel with its own worker, and loads the resulting routes
+	void searchRouteGroups(const Individual & indiv);
+
+	// (Worker) Loads the routes of routeGroup from indiv, and runs the search with the given penalties restricted to these routes
+	void searchRouteGroup(const Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS);
+
+	// Loop of thread workerThreads[w-1], improving the group of workers[w] in each parallel search
+	void runWorkerThread(int w);
+
+	// Prepares a new search on the current solution, starting with loop firstLoopID
+	void startSearch(int firstLoopID);
+
+	// Tells whether indiv is the solution currently held in the linked lists (same successors and predecessors)
+	bool isLoaded(const Individual & indiv);
+
+	// Runs the loops of RI and SWAP* moves until no improving move is found (returns true), or until the budget of the call is exhausted (returns false)
+	// In the latter case, the next call continues the loops from where they have been interrupted
+	bool searchLoops();
+
+	// Tells whether the move budget (params.ap.maxMovesLS) or time budget (params.ap.timeLimitLS) of the current call is exhausted
+	inline bool isBudgetExhausted()
+	{
+		if (params.ap.maxMovesLS > 0 && nbMoves - nbMovesStartCall >= params.ap.maxMovesLS) return true;
+		return (params.ap.timeLimitLS > 0 && ++nbBudgetChecks % 64 == 0 && (double)(clock() - clockStartCall) / (double)CLOCKS_PER_SEC >= params.ap.timeLimitLS);
+	}
 
 	public:
 
+	int nbCalls;								// Number of calls to run
+	int nbInterruptions;						// Number of these calls whose search has been interrupted at least once because its budget was exhausted
+	long long nbLoops;							// Number of loops over the nodes and routes (the ones of the workers are counted by the workers)
+	long long nbMoveEvaluations[NB_MOVE_TYPES];	// Number of evaluations of each move type (see Statistics.h)
+	long long nbMoveSuccesses[NB_MOVE_TYPES];	// Number of improving moves applied for each move type
+
+	// Adds the loop and move counters of this local search and of its workers to the statistics
+	void addMoveStatistics(Statistics & stats) const;
+
+	/* CONSISTENCY CHECKS OF THE INCREMENTAL DATA (USED BY THE TESTS), THROWING A DESCRIPTION OF THE FIRST INCONSISTENCY FOUND */
+
+	// Updates the SWAP* insertion memory of the customers of each non-empty route in each other non-empty route, as before a SWAP* evaluation, and compares it with a complete recalculation
+	void checkInsertionMemory();
+
+	// Compares the preprocessed data of the nodes and routes (positions, cumulated values, circle sectors, empty routes and index of sectors) with a complete recalculation
+	void checkRouteData();
+
 	// Run the local search with the specified penalty values
-	void run(Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS);
+	// Returns false if the search has been interrupted by the budget of the call, in which case indiv is left unchanged until the search is continued with resume
+	bool run(Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS);
+
+	// Continues the search from the solution of the last call to run with new penalty values (typically, to repair an infeasible solution), without reloading it
+	// Precondition: indiv must be the solution registered by this last call, or by the resume completing it (otherwise an exception is thrown), it receives the repaired solution
+	// Returns false if the search has been interrupted by the budget of the call, in which case indiv is left unchanged until the search is continued with resume
+	bool repair(Individual & indiv, double penaltyCapacityLS, double penaltyDurationLS);
+
+	// Continues an interrupted search (by slices of the budget of one call) until it completes or until the time limit of the algorithm is reached, and registers the current solution in indiv
+	// Returns false if the search has been stopped by the time limit
+	bool resume(Individual & indiv);
 
 	// Loading an initial solution into the local search
 	void loadIndividual(const Individual & indiv);
 
+	// Loading the routes whose indices are listed in routeIndices, given as segments of a giant tour as in Individual. The other routes and their customers are left out of the search
+	void loadRoutes(const std::vector <int> & chromT, const std::vector <int> & routeStarts, const std::vector <int> & routeIndices);
+
+	// Loading the sequence of customers of route r (part of loadRoutes)
+	void loadRoute(int r, const int * sequence, int nbCustomers);
+
 	// Exporting the LS solution into an individual and calculating the penalized cost according to the original penalty weights from Params
 	void exportIndividual(Individual & indiv);
 
 	// Constructor
 	LocalSearch(Params & params);
+
+	// Constructor of a worker of the parallel search, using its own random number generator and the trace buffer of its thread
+	LocalSearch(Params & params, std::minstd_rand & ran, TraceBuffer & traceBuffer);
+
+	// Destructor, stopping the threads of the parallel search
+	~LocalSearch();
 };
 
 #endif
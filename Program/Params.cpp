@@ -21,6 +21,9 @@ Params::Params(
 {
 	// This marks the starting time of the algorithm
 	startTime = clock();
+	startWallClock = wallClock();
+	stats = Statistics();
+	traceBuffers = std::vector < TraceBuffer >(std::max<int>(1, ap.nbThreadsLS), TraceBuffer(ap.traceSize));
 
 	nbClients = (int)demands.size() - 1; // Need to substract the depot from the number of nodes
 	totalDemand = 0.;
@@ -112,6 +115,10 @@ Params::Params(
 	if (nbVehicles < std::ceil(totalDemand / vehicleCapacity))
 		throw std::string("Fleet size is insufficient to service the considered clients.");
 
+	routeCache = std::vector<RouteEvaluation>(std::max<int>(0, ap.routeCacheSize));
+	nbRouteCacheLookups = 0;
+	nbRouteCacheHits = 0;
+
 	// A reasonable scale for the initial values of the penalties
 	penaltyDuration = 1;
 	penaltyCapacity = std::max<double>(0.1, std::min<double>(1000., maxDist / maxDemand));
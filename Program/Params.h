@@ -25,6 +25,8 @@ SOFTWARE.*/
 
 #include "CircleSector.h"
 #include "AlgorithmParameters.h"
+#include "Statistics.h"
+#include "Trace.h"
 #include <string>
 #include <vector>
 #include <list>
@@ -32,6 +34,7 @@ SOFTWARE.*/
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <cmath>
 #include <time.h>
 #include <climits>
@@ -50,6 +53,30 @@ struct Client
 	int polarAngle;			// Polar angle of the client around the depot, measured in degrees and truncated for convenience
 };
 
+// Adds the wall-clock time elapsed between its construction and its destruction to a time of Statistics, and records this phase in a trace buffer
+struct PhaseTimer
+{
+	double & time;
+	TraceBuffer & traceBuffer;
+	const char * name;
+	double startTime;
+	PhaseTimer(double & time, TraceBuffer & traceBuffer, const char * name) : time(time), traceBuffer(traceBuffer), name(name), startTime(wallClock()) {}
+	~PhaseTimer() { double endTime = wallClock(); time += endTime - startTime; traceBuffer.add(name, startTime, endTime); }
+};
+
+// Evaluation of a route, as stored in the cache of route evaluations
+// An entry is only used for a route with the same hash, number of customers, extremities and load: a wrong evaluation requires a collision of the 64-bit hashes of two routes also sharing these characteristics
+struct RouteEvaluation
+{
+	size_t key = 0;			// Hash of the sequence of customers of the route
+	int nbCustomers = 0;	// Number of customers of the route (0 for an unused entry)
+	int first = 0;			// First customer of the route
+	int last = 0;			// Last customer of the route
+	double distance = 0.;	// Distance of the route
+	double load = 0.;		// Total demand of the route
+	double service = 0.;	// Total service duration of the route
+};
+
 class Params
 {
 public:
@@ -64,6 +91,13 @@ public:
 
 	/* START TIME OF THE ALGORITHM */
 	clock_t startTime;                  // Start time of the optimization (set when Params is constructed)
+	double startWallClock;              // Same, in wall-clock time
+
+	/* STATISTICS */
+	mutable Statistics stats;           // Counters and times of the phases of the algorithm (except the move counters, kept by the local search structures, see Population::getStatistics)
+
+	/* TRACE OF THE PHASES */
+	mutable std::vector < TraceBuffer > traceBuffers;	// One ring buffer of ap.traceSize events per thread: traceBuffers[0] for the calling thread, traceBuffers[w] for the thread of worker w of the parallel local search
 
 	/* RANDOM NUMBER GENERATOR */       
 	std::minstd_rand ran;               // Using the fastest and simplest LCG. The quality of random numbers is not critical for the LS, but speed is
@@ -82,6 +116,12 @@ public:
 	std::vector< std::vector< int > > correlatedVertices;	// Neighborhood restrictions: For each client, list of nearby customers
 	bool areCoordinatesProvided;                            // Check if valid coordinates are provided
 
+	/* CACHE OF ROUTE EVALUATIONS (ap.routeCacheSize > 0) */
+	// Mutable as it is filled by the evaluation of the individuals, which does not modify the problem parameters
+	mutable std::vector< RouteEvaluation > routeCache;		// Direct-mapped cache: each route is stored at the position given by its hash, in place of the previous one
+	mutable long long nbRouteCacheLookups;					// Number of routes searched in the cache
+	mutable long long nbRouteCacheHits;						// Number of routes found in the cache
+
 	// Initialization from a given data set
 	Params(const std::vector<double>& x_coords,
 		const std::vector<double>& y_coords,
@@ -2,16 +2,17 @@
 
 void Population::generatePopulation()
 {
+	TraceScope traceScope(params.traceBuffers[0], "generatePopulation");
 	if (params.verbose) std::cout << "----- BUILDING INITIAL POPULATION" << std::endl;
 	for (int i = 0; i < 4*params.ap.mu && (i == 0 || params.ap.timeLimit == 0 || (double)(clock() - params.startTime) / (double)CLOCKS_PER_SEC < params.ap.timeLimit) ; i++)
 	{
 		Individual randomIndiv(params);
 		split.generalSplit(randomIndiv, params.nbVehicles);
-		localSearch.run(randomIndiv, params.penaltyCapacity, params.penaltyDuration);
+		if (!localSearch.run(randomIndiv, params.penaltyCapacity, params.penaltyDuration)) localSearch.resume(randomIndiv); // An interrupted search is resumed as long as the time limit allows it
 		addIndividual(randomIndiv, true);
 		if (!randomIndiv.eval.isFeasible && params.ran() % 2 == 0)  // Repair half of the solutions in case of infeasibility
 		{
-			localSearch.run(randomIndiv, params.penaltyCapacity*10., params.penaltyDuration*10.);
+			if (!localSearch.repair(randomIndiv, params.penaltyCapacity*10., params.penaltyDuration*10.)) localSearch.resume(randomIndiv);
 			if (randomIndiv.eval.isFeasible) addIndividual(randomIndiv, false);
 		}
 	}
@@ -19,25 +20,39 @@ void Population::generatePopulation()
 
 bool Population::addIndividual(const Individual & indiv, bool updateFeasible)
 {
+	PhaseTimer timer(params.stats.timePopulation, params.traceBuffers[0], "addIndividual");
+	params.stats.nbInsertions++;
 	if (updateFeasible)
 	{
-		listFeasibilityLoad.push_back(indiv.eval.capacityExcess < MY_EPSILON);
-		listFeasibilityDuration.push_back(indiv.eval.durationExcess < MY_EPSILON);
-		listFeasibilityLoad.pop_front();
-		listFeasibilityDuration.pop_front();
+		feasibilityLoad.add(indiv.eval.capacityExcess < MY_EPSILON);
+		feasibilityDuration.add(indiv.eval.durationExcess < MY_EPSILON);
 	}
 
 	// Find the adequate subpopulation in relation to the individual feasibility
 	SubPopulation & subpop = (indiv.eval.isFeasible) ? feasibleSubpop : infeasibleSubpop;
 
-	// Create a copy of the individual and updade the proximity structures calculating inter-individual distances
-	Individual * myIndividual = new Individual(indiv);
+	// Copy the individual in an individual of the pool (whose vectors already have their size) and updade the proximity structures calculating inter-individual distances
+	Individual * myIndividual = freeIndividuals.back();
+	freeIndividuals.pop_back();
+	*myIndividual = indiv;
+	ProximityStructure & proximity = getProximity(subpop);
+	myIndividual->proximitySlot = proximity.freeSlots.back();
+	proximity.freeSlots.pop_back();
+	proximity.nbClones[myIndividual->proximitySlot] = 0;
 	for (Individual * myIndividual2 : subpop)
 	{
+		if (myIndividual2->solutionHash == myIndividual->solutionHash)
+		{
+			proximity.nbClones[myIndividual->proximitySlot]++;
+			proximity.nbClones[myIndividual2->proximitySlot]++;
+		}
 		double myDistance = brokenPairsDistance(*myIndividual,*myIndividual2);
-		myIndividual2->indivsPerProximity.insert({ myDistance, myIndividual });
-		myIndividual->indivsPerProximity.insert({ myDistance, myIndividual2 });
+		proximity.distances[myIndividual->proximitySlot * proximity.nbSlots + myIndividual2->proximitySlot] = myDistance;
+		proximity.distances[myIndividual2->proximitySlot * proximity.nbSlots + myIndividual->proximitySlot] = myDistance;
+		insertClosest(proximity, *myIndividual2, myDistance, myIndividual->proximitySlot);
 	}
+	updateClosest(subpop, *myIndividual);
+	isModified(subpop) = true;
 
 	// Identify the correct location in the subpopulation and insert the individual
 	int place = (int)subpop.size();
@@ -66,10 +81,13 @@ bool Population::addIndividual(const Individual & indiv, bool updateFeasible)
 
 void Population::updateBiasedFitnesses(SubPopulation & pop)
 {
+	if (!isModified(pop)) return;
+	isModified(pop) = false;
+
 	// Ranking the individuals based on their diversity contribution (decreasing order of distance)
-	std::vector <std::pair <double, int> > ranking;
+	ranking.clear();
 	for (int i = 0 ; i < (int)pop.size(); i++) 
-		ranking.push_back({-averageBrokenPairsDistanceClosest(*pop[i],params.ap.nbClose),i});
+		ranking.push_back({-pop[i]->diversityContribution,i});
 	std::sort(ranking.begin(), ranking.end());
 
 	// Updating the biased fitness values
@@ -94,13 +112,14 @@ void Population::removeWorstBiasedFitness(SubPopulation & pop)
 	updateBiasedFitnesses(pop);
 	if (pop.size() <= 1) throw std::string("Eliminating the best individual: this should not occur in HGS");
 
+	ProximityStructure & proximity = getProximity(pop);
 	Individual * worstIndividual = NULL;
 	int worstIndividualPosition = -1;
 	bool isWorstIndividualClone = false;
 	double worstIndividualBiasedFitness = -1.e30;
 	for (int i = 1; i < (int)pop.size(); i++)
 	{
-		bool isClone = (averageBrokenPairsDistanceClosest(*pop[i],1) < MY_EPSILON); // A distance equal to 0 indicates that a clone exists
+		bool isClone = (proximity.nbClones[pop[i]->proximitySlot] > 0); // Another individual has the same routes
 		if ((isClone && !isWorstIndividualClone) || (isClone == isWorstIndividualClone && pop[i]->biasedFitness > worstIndividualBiasedFitness))
 		{
 			worstIndividualBiasedFitness = pop[i]->biasedFitness;
@@ -110,43 +129,63 @@ void Population::removeWorstBiasedFitness(SubPopulation & pop)
 		}
 	}
 
-	// Removing the individual from the population and freeing memory
+	// Removing the individual from the population
 	pop.erase(pop.begin() + worstIndividualPosition); 
+	isModified(pop) = true;
 
-	// Cleaning its distances from the other individuals in the population
+	// Releasing its slot in the proximity structure
+	// The closest individuals and diversity contribution only change for the individuals which had it among their nbClose closest individuals
+	proximity.freeSlots.push_back(worstIndividual->proximitySlot);
 	for (Individual * indiv2 : pop)
 	{
-		auto it = indiv2->indivsPerProximity.begin();
-		while (it->second != worstIndividual) ++it;
-		indiv2->indivsPerProximity.erase(it);
+		if (indiv2->solutionHash == worstIndividual->solutionHash) proximity.nbClones[indiv2->proximitySlot]--;
+		for (const std::pair <double, int> & myPair : proximity.closest[indiv2->proximitySlot])
+		{
+			if (myPair.second == worstIndividual->proximitySlot)
+			{
+				updateClosest(pop, *indiv2);
+				break;
+			}
+		}
 	}
 
-	// Freeing memory
-	delete worstIndividual; 
+	// Returning the individual to the pool
+	freeIndividuals.push_back(worstIndividual);
 }
 
 void Population::restart()
 {
+	TraceScope traceScope(params.traceBuffers[0], "restart");
 	if (params.verbose) std::cout << "----- RESET: CREATING A NEW POPULATION -----" << std::endl;
-	for (Individual * indiv : feasibleSubpop) delete indiv ;
-	for (Individual * indiv : infeasibleSubpop) delete indiv;
+	freeIndividuals.insert(freeIndividuals.end(), feasibleSubpop.begin(), feasibleSubpop.end());
+	freeIndividuals.insert(freeIndividuals.end(), infeasibleSubpop.begin(), infeasibleSubpop.end());
 	feasibleSubpop.clear();
 	infeasibleSubpop.clear();
+	for (ProximityStructure * proximity : { &feasibleProximity, &infeasibleProximity })
+	{
+		proximity->freeSlots.clear();
+		for (int slot = proximity->nbSlots - 1; slot >= 0; slot--) proximity->freeSlots.push_back(slot);
+	}
+	isFeasibleSubpopModified = true;
+	isInfeasibleSubpopModified = true;
 	bestSolutionRestart = Individual(params);
 	generatePopulation();
 }
 
 void Population::managePenalties()
 {
+	PhaseTimer timer(params.stats.timePenaltyUpdates, params.traceBuffers[0], "managePenalties");
+	params.stats.nbPenaltyUpdates++;
+
 	// Setting some bounds [0.1,100000] to the penalty values for safety
-	double fractionFeasibleLoad = (double)std::count(listFeasibilityLoad.begin(), listFeasibilityLoad.end(), true) / (double)listFeasibilityLoad.size();
+	double fractionFeasibleLoad = feasibilityLoad.fractionFeasible();
 	if (fractionFeasibleLoad < params.ap.targetFeasible - 0.05 && params.penaltyCapacity < 100000.)
 		params.penaltyCapacity = std::min<double>(params.penaltyCapacity * params.ap.penaltyIncrease, 100000.);
 	else if (fractionFeasibleLoad > params.ap.targetFeasible + 0.05 && params.penaltyCapacity > 0.1)
 		params.penaltyCapacity = std::max<double>(params.penaltyCapacity * params.ap.penaltyDecrease, 0.1);
 
 	// Setting some bounds [0.1,100000] to the penalty values for safety
-	double fractionFeasibleDuration = (double)std::count(listFeasibilityDuration.begin(), listFeasibilityDuration.end(), true) / (double)listFeasibilityDuration.size();
+	double fractionFeasibleDuration = feasibilityDuration.fractionFeasible();
 	if (fractionFeasibleDuration < params.ap.targetFeasible - 0.05 && params.penaltyDuration < 100000.)
 		params.penaltyDuration = std::min<double>(params.penaltyDuration * params.ap.penaltyIncrease, 100000.);
 	else if (fractionFeasibleDuration > params.ap.targetFeasible + 0.05 && params.penaltyDuration > 0.1)
@@ -158,23 +197,29 @@ void Population::managePenalties()
 		+ params.penaltyCapacity * infeasibleSubpop[i]->eval.capacityExcess
 		+ params.penaltyDuration * infeasibleSubpop[i]->eval.durationExcess;
 
-	// If needed, reorder the individuals in the infeasible subpopulation since the penalty values have changed (simple bubble sort for the sake of simplicity)
-	for (int i = 0; i < (int)infeasibleSubpop.size(); i++)
+	// If needed, reorder the individuals in the infeasible subpopulation since the penalty values have changed
+	// Insertion sort: the order changes little with the penalty values, hence a time close to linear
+	for (int i = 1; i < (int)infeasibleSubpop.size(); i++)
 	{
-		for (int j = 0; j < (int)infeasibleSubpop.size() - i - 1; j++)
+		Individual * indiv = infeasibleSubpop[i];
+		int j = i;
+		while (j > 0 && infeasibleSubpop[j - 1]->eval.penalizedCost > indiv->eval.penalizedCost + MY_EPSILON)
 		{
-			if (infeasibleSubpop[j]->eval.penalizedCost > infeasibleSubpop[j + 1]->eval.penalizedCost + MY_EPSILON)
-			{
-				Individual * indiv = infeasibleSubpop[j];
-				infeasibleSubpop[j] = infeasibleSubpop[j + 1];
-				infeasibleSubpop[j + 1] = indiv;
-			}
+			infeasibleSubpop[j] = infeasibleSubpop[j - 1];
+			j--;
+		}
+		if (j < i)
+		{
+			infeasibleSubpop[j] = indiv;
+			isInfeasibleSubpopModified = true; // The ranks in terms of penalized cost have changed
 		}
 	}
 }
 
 const Individual & Population::getBinaryTournament ()
 {
+	PhaseTimer timer(params.stats.timePopulation, params.traceBuffers[0], "getBinaryTournament");
+
 	// Picking two individuals with uniform distribution over the union of the feasible and infeasible subpopulations
 	std::uniform_int_distribution<> distr(0, feasibleSubpop.size() + infeasibleSubpop.size() - 1);
 	int place1 = distr(params.ran);
@@ -220,33 +265,95 @@ void Population::printState(int nbIter, int nbIterNoImprovement)
 		else std::printf(" | NO-INFEASIBLE");
 
 		std::printf(" | Div %.2f %.2f", getDiversity(feasibleSubpop), getDiversity(infeasibleSubpop));
-		std::printf(" | Feas %.2f %.2f", (double)std::count(listFeasibilityLoad.begin(), listFeasibilityLoad.end(), true) / (double)listFeasibilityLoad.size(), (double)std::count(listFeasibilityDuration.begin(), listFeasibilityDuration.end(), true) / (double)listFeasibilityDuration.size());
+		std::printf(" | Feas %.2f %.2f", feasibilityLoad.fractionFeasible(), feasibilityDuration.fractionFeasible());
 		std::printf(" | Pen %.2f %.2f", params.penaltyCapacity, params.penaltyDuration);
+		if (params.ap.maxMovesLS > 0 || params.ap.timeLimitLS > 0) std::printf(" | LS-Int %d %d", localSearch.nbInterruptions, localSearch.nbCalls);
+		if (params.nbRouteCacheLookups > 0) std::printf(" | RC-Hit %.2f", (double)params.nbRouteCacheHits / (double)params.nbRouteCacheLookups);
 		std::cout << std::endl;
+		if (params.ap.printStatistics)
+		{
+			Statistics stats = getStatistics();
+			long long nbEvaluationsRI = 0;
+			long long nbSuccessesRI = 0;
+			for (int k = 1; k < NB_MOVE_TYPES; k++) { nbEvaluationsRI += stats.nbMoveEvaluations[k]; nbSuccessesRI += stats.nbMoveSuccesses[k]; }
+			std::printf("   Stats | Xover %lld %.2fs | Split %lld LF %lld %.2fs | LS %lld %.2fs Loops %lld RI %lld/%lld SWAP* %lld/%lld | Repair %lld %.2fs | Pop %lld %.2fs BPD %lld | Pen %lld %.2fs\n",
+				stats.nbCrossovers, stats.timeCrossover, stats.nbSplits, stats.nbSplitsLF, stats.timeSplit,
+				stats.nbLocalSearches, stats.timeLocalSearch, stats.nbLoopsLS, nbSuccessesRI, nbEvaluationsRI, stats.nbMoveSuccesses[0], stats.nbMoveEvaluations[0],
+				stats.nbRepairs, stats.timeRepair, stats.nbInsertions, stats.timePopulation, stats.nbBrokenPairsDistances, stats.nbPenaltyUpdates, stats.timePenaltyUpdates);
+		}
 	}
 }
 
+Statistics Population::getStatistics()
+{
+	Statistics stats = params.stats;
+	stats.time = wallClock() - params.startWallClock;
+	localSearch.addMoveStatistics(stats);
+	stats.nbRouteCacheLookups = params.nbRouteCacheLookups;
+	stats.nbRouteCacheHits = params.nbRouteCacheHits;
+	return stats;
+}
+
 double Population::brokenPairsDistance(const Individual & indiv1, const Individual & indiv2)
 {
+	params.stats.nbBrokenPairsDistances++;
+
+	// Branchless loop on raw arrays, which the compiler can vectorize
+	const int * successors1 = indiv1.successors.data();
+	const int * predecessors1 = indiv1.predecessors.data();
+	const int * successors2 = indiv2.successors.data();
+	const int * predecessors2 = indiv2.predecessors.data();
 	int differences = 0;
 	for (int j = 1; j <= params.nbClients; j++)
 	{
-		if (indiv1.successors[j] != indiv2.successors[j] && indiv1.successors[j] != indiv2.predecessors[j]) differences++;
-		if (indiv1.predecessors[j] == 0 && indiv2.predecessors[j] != 0 && indiv2.successors[j] != 0) differences++;
+		differences += (successors1[j] != successors2[j]) & (successors1[j] != predecessors2[j]);
+		differences += (predecessors1[j] == 0) & (predecessors2[j] != 0) & (successors2[j] != 0);
 	}
 	return (double)differences / (double)params.nbClients;
 }
 
-double Population::averageBrokenPairsDistanceClosest(const Individual & indiv, int nbClosest)
+void Population::updateClosest(const SubPopulation & pop, Individual & indiv)
+{
+	ProximityStructure & proximity = getProximity(pop);
+	std::vector < std::pair <double, int> > & closest = proximity.closest[indiv.proximitySlot];
+	distancesToSort.clear();
+	for (Individual * indiv2 : pop)
+		if (indiv2 != &indiv) distancesToSort.push_back({ proximity.distances[indiv.proximitySlot * proximity.nbSlots + indiv2->proximitySlot], indiv2->proximitySlot });
+	int nbClosest = std::min<int>(params.ap.nbClose, distancesToSort.size());
+	std::partial_sort(distancesToSort.begin(), distancesToSort.begin() + nbClosest, distancesToSort.end());
+	closest.assign(distancesToSort.begin(), distancesToSort.begin() + nbClosest);
+	indiv.diversityContribution = averageBrokenPairsDistanceClosest(pop, indiv, params.ap.nbClose);
+}
+
+void Population::insertClosest(ProximityStructure & proximity, Individual & indiv, double distance, int slot)
 {
+	std::vector < std::pair <double, int> > & closest = proximity.closest[indiv.proximitySlot];
+	if ((int)closest.size() == params.ap.nbClose && distance >= closest.back().first) return;
+	closest.insert(std::upper_bound(closest.begin(), closest.end(), std::pair <double, int>(distance, slot)), { distance, slot });
+	if ((int)closest.size() > params.ap.nbClose) closest.pop_back();
+	double sumDistances = 0.;
+	for (const std::pair <double, int> & myPair : closest) sumDistances += myPair.first;
+	indiv.diversityContribution = sumDistances / (double)closest.size();
+}
+
+double Population::averageBrokenPairsDistanceClosest(const SubPopulation & pop, const Individual & indiv, int nbClosest)
+{
+	// The closest individuals are directly available up to nbClose, otherwise they are found from the distances
+	ProximityStructure & proximity = getProximity(pop);
+	const std::vector < std::pair <double, int> > & closest = proximity.closest[indiv.proximitySlot];
 	double result = 0.;
-	int maxSize = std::min<int>(nbClosest, indiv.indivsPerProximity.size());
-	auto it = indiv.indivsPerProximity.begin();
-	for (int i = 0; i < maxSize; i++)
+	if (nbClosest <= params.ap.nbClose)
 	{
-		result += it->first;
-		++it;
+		int maxSize = std::min<int>(nbClosest, closest.size());
+		for (int i = 0; i < maxSize; i++) result += closest[i].first;
+		return result / (double)maxSize;
 	}
+	distancesToSort.clear();
+	for (Individual * indiv2 : pop)
+		if (indiv2 != &indiv) distancesToSort.push_back({ proximity.distances[indiv.proximitySlot * proximity.nbSlots + indiv2->proximitySlot], indiv2->proximitySlot });
+	int maxSize = std::min<int>(nbClosest, distancesToSort.size());
+	std::partial_sort(distancesToSort.begin(), distancesToSort.begin() + maxSize, distancesToSort.end());
+	for (int i = 0; i < maxSize; i++) result += distancesToSort[i].first;
 	return result / (double)maxSize;
 }
 
@@ -254,7 +361,7 @@ double Population::getDiversity(const SubPopulation & pop)
 {
 	double average = 0.;
 	int size = std::min<int>(params.ap.mu, pop.size()); // Only monitoring the "mu" better solutions to avoid too much noise in the measurements
-	for (int i = 0; i < size; i++) average += averageBrokenPairsDistanceClosest(*pop[i],size);
+	for (int i = 0; i < size; i++) average += averageBrokenPairsDistanceClosest(pop,*pop[i],size);
 	if (size > 0) return average / (double)size;
 	else return -1.0;
 }
@@ -275,17 +382,74 @@ void Population::exportSearchProgress(std::string fileName, std::string instance
 		myfile << instanceName << ";" << params.ap.seed << ";" << state.second << ";" << (double)state.first / (double)CLOCKS_PER_SEC << std::endl;
 }
 
+void Population::exportStatistics(std::string fileName)
+{
+	Statistics stats = getStatistics();
+	std::ofstream myfile(fileName);
+	if (myfile.is_open())
+	{
+		myfile << "{" << std::endl;
+		myfile << "  \"time\": " << stats.time << "," << std::endl;
+		myfile << "  \"nbIterations\": " << stats.nbIterations << "," << std::endl;
+		myfile << "  \"crossover\": { \"count\": " << stats.nbCrossovers << ", \"time\": " << stats.timeCrossover << " }," << std::endl;
+		myfile << "  \"split\": { \"count\": " << stats.nbSplits << ", \"countLF\": " << stats.nbSplitsLF << ", \"time\": " << stats.timeSplit << " }," << std::endl;
+		myfile << "  \"localSearch\": { \"count\": " << stats.nbLocalSearches << ", \"loops\": " << stats.nbLoopsLS << ", \"time\": " << stats.timeLocalSearch << "," << std::endl;
+		myfile << "    \"moves\": {";
+		for (int k = 0; k < NB_MOVE_TYPES; k++)
+		{
+			myfile << (k == 0 ? " \"swapStar\"" : ", \"move" + std::to_string(k) + "\"");
+			myfile << ": { \"evaluations\": " << stats.nbMoveEvaluations[k] << ", \"successes\": " << stats.nbMoveSuccesses[k] << " }";
+		}
+		myfile << " } }," << std::endl;
+		myfile << "  \"repair\": { \"count\": " << stats.nbRepairs << ", \"time\": " << stats.timeRepair << " }," << std::endl;
+		myfile << "  \"population\": { \"insertions\": " << stats.nbInsertions << ", \"brokenPairsDistances\": " << stats.nbBrokenPairsDistances << ", \"time\": " << stats.timePopulation << " }," << std::endl;
+		myfile << "  \"penaltyUpdates\": { \"count\": " << stats.nbPenaltyUpdates << ", \"time\": " << stats.timePenaltyUpdates << " }," << std::endl;
+		myfile << "  \"routeCache\": { \"lookups\": " << stats.nbRouteCacheLookups << ", \"hits\": " << stats.nbRouteCacheHits << " }" << std::endl;
+		myfile << "}" << std::endl;
+	}
+	else std::cout << "----- IMPOSSIBLE TO OPEN: " << fileName << std::endl;
+}
+
+void Population::exportTrace(std::string fileName)
+{
+	std::ofstream myfile(fileName);
+	if (myfile.is_open())
+	{
+		// Complete events ("X"), with times in microseconds since the start of the algorithm. Each buffer is written from its oldest kept event
+		long long nbEventsLost = 0;
+		bool isFirstEvent = true;
+		myfile << "{\"traceEvents\":[" << std::endl;
+		for (int t = 0; t < (int)params.traceBuffers.size(); t++)
+		{
+			const TraceBuffer & traceBuffer = params.traceBuffers[t];
+			long long nbEventsKept = std::min<long long>(traceBuffer.nbEvents, (long long)traceBuffer.events.size());
+			nbEventsLost += traceBuffer.nbEvents - nbEventsKept;
+			myfile << (isFirstEvent ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t << ",\"args\":{\"name\":\"" << (t == 0 ? "main" : "worker " + std::to_string(t)) << "\"}}";
+			isFirstEvent = false;
+			for (long long k = traceBuffer.nbEvents - nbEventsKept; k < traceBuffer.nbEvents; k++)
+			{
+				const TraceEvent & event = traceBuffer.events[k % (long long)traceBuffer.events.size()];
+				myfile << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t
+					<< ",\"ts\":" << std::fixed << std::setprecision(3) << 1.e6 * (event.startTime - params.startWallClock)
+					<< ",\"dur\":" << 1.e6 * (event.endTime - event.startTime) << "}";
+			}
+		}
+		myfile << std::endl << "],\"otherData\":{\"nbEventsLost\":" << nbEventsLost << "}}" << std::endl;
+	}
+	else std::cout << "----- IMPOSSIBLE TO OPEN: " << fileName << std::endl;
+}
+
 void Population::exportCVRPLibFormat(const Individual & indiv, std::string fileName)
 {
 	std::ofstream myfile(fileName);
 	if (myfile.is_open())
 	{
-		for (int k = 0; k < (int)indiv.chromR.size(); k++)
+		for (int k = 0; k < params.nbVehicles; k++)
 		{
-			if (!indiv.chromR[k].empty())
+			if (!indiv.route(k).empty())
 			{
 				myfile << "Route #" << k + 1 << ":"; // Route IDs start at 1 in the file format
-				for (int i : indiv.chromR[k]) myfile << " " << i;
+				for (int i : indiv.route(k)) myfile << " " << i;
 				myfile << std::endl;
 			}
 		}
@@ -294,14 +458,118 @@ void Population::exportCVRPLibFormat(const Individual & indiv, std::string fileN
 	else std::cout << "----- IMPOSSIBLE TO OPEN: " << fileName << std::endl;
 }
 
-Population::Population(Params & params, Split & split, LocalSearch & localSearch) : params(params), split(split), localSearch(localSearch), bestSolutionRestart(params), bestSolutionOverall(params)
+void Population::checkSubpopulations()
 {
-	listFeasibilityLoad = std::list<bool>(params.ap.nbIterPenaltyManagement, true);
-	listFeasibilityDuration = std::list<bool>(params.ap.nbIterPenaltyManagement, true);
+	for (SubPopulation * pop : { &feasibleSubpop, &infeasibleSubpop })
+	{
+		std::string context = (pop == &feasibleSubpop) ? " in the feasible subpopulation" : " in the infeasible subpopulation";
+		updateBiasedFitnesses(*pop);
+
+		// Penalized costs recalculated with the current penalties, and order compared with a sort of these costs
+		std::vector <double> sortedCosts;
+		for (Individual * indiv : *pop)
+		{
+			double penalizedCost = indiv->eval.distance + params.penaltyCapacity * indiv->eval.capacityExcess + params.penaltyDuration * indiv->eval.durationExcess;
+			if (std::fabs(indiv->eval.penalizedCost - penalizedCost) > 1.e-9 * std::max<double>(1., penalizedCost))
+				throw std::string("Incorrect penalized cost of slot " + std::to_string(indiv->proximitySlot) + context);
+			sortedCosts.push_back(indiv->eval.penalizedCost);
+		}
+		std::sort(sortedCosts.begin(), sortedCosts.end());
+		for (int i = 0; i < (int)pop->size(); i++)
+			if (std::fabs((*pop)[i]->eval.penalizedCost - sortedCosts[i]) > MY_EPSILON)
+				throw std::string("Individual " + std::to_string(i) + context + " not ordered by penalized cost");
+
+		// Slots of the individuals, distances, closest individuals and diversity contributions recalculated from the solutions
+		ProximityStructure & proximity = getProximity(*pop);
+		std::vector <bool> isSlotUsed(proximity.nbSlots, false);
+		for (int slot : proximity.freeSlots) isSlotUsed[slot] = true;
+		for (Individual * indiv : *pop)
+		{
+			if (isSlotUsed[indiv->proximitySlot]) throw std::string("Slot " + std::to_string(indiv->proximitySlot) + " used twice" + context);
+			isSlotUsed[indiv->proximitySlot] = true;
+		}
+		if ((int)(pop->size() + proximity.freeSlots.size()) != proximity.nbSlots) throw std::string("Slots lost" + context);
+
+		// Solution hashes recalculated from the routes, and numbers of clones
+		for (Individual * indiv : *pop)
+		{
+			int nbClones = 0;
+			for (Individual * indiv2 : *pop) if (indiv2 != indiv && indiv2->solutionHash == indiv->solutionHash) nbClones++;
+			if (proximity.nbClones[indiv->proximitySlot] != nbClones) throw std::string("Incorrect number of clones of slot " + std::to_string(indiv->proximitySlot) + context);
+			Individual evaluated = *indiv;
+			evaluated.evaluateCompleteCost(params);
+			if (evaluated.solutionHash != indiv->solutionHash) throw std::string("Incorrect solution hash of slot " + std::to_string(indiv->proximitySlot) + context);
+		}
+		for (Individual * indiv : *pop)
+		{
+			std::vector <double> referenceDistances;
+			for (Individual * indiv2 : *pop)
+			{
+				if (indiv2 == indiv) continue;
+				// The broken pairs distance is not symmetric: the one from the last inserted individual of the pair is stored in both directions
+				double distance = proximity.distances[indiv->proximitySlot * proximity.nbSlots + indiv2->proximitySlot];
+				if ((distance != brokenPairsDistance(*indiv, *indiv2) && distance != brokenPairsDistance(*indiv2, *indiv))
+					|| distance != proximity.distances[indiv2->proximitySlot * proximity.nbSlots + indiv->proximitySlot])
+					throw std::string("Incorrect distance between slots " + std::to_string(indiv->proximitySlot) + " and " + std::to_string(indiv2->proximitySlot) + context);
+				referenceDistances.push_back(distance);
+			}
+			std::sort(referenceDistances.begin(), referenceDistances.end());
+			const std::vector < std::pair <double, int> > & closest = proximity.closest[indiv->proximitySlot];
+			int nbClosest = std::min<int>(params.ap.nbClose, referenceDistances.size());
+			if ((int)closest.size() != nbClosest) throw std::string("Incorrect number of closest individuals of slot " + std::to_string(indiv->proximitySlot) + context);
+			double sumDistances = 0.;
+			for (int i = 0; i < nbClosest; i++)
+			{
+				if (closest[i].first != referenceDistances[i]) throw std::string("Incorrect closest individuals of slot " + std::to_string(indiv->proximitySlot) + context);
+				sumDistances += referenceDistances[i];
+			}
+			if (nbClosest > 0 && std::fabs(indiv->diversityContribution - sumDistances / (double)nbClosest) > 1.e-9)
+				throw std::string("Incorrect diversity contribution of slot " + std::to_string(indiv->proximitySlot) + context);
+		}
+
+		// Biased fitnesses recalculated from the diversity contributions
+		std::vector < std::pair <double, int> > referenceRanking;
+		for (int i = 0; i < (int)pop->size(); i++) referenceRanking.push_back({ -(*pop)[i]->diversityContribution, i });
+		std::sort(referenceRanking.begin(), referenceRanking.end());
+		for (int i = 0; i < (int)pop->size(); i++)
+		{
+			double referenceBiasedFitness = 0.;
+			if (pop->size() > 1)
+			{
+				double divRank = (double)i / (double)(pop->size() - 1);
+				double fitRank = (double)referenceRanking[i].second / (double)(pop->size() - 1);
+				referenceBiasedFitness = ((int)pop->size() <= params.ap.nbElite) ? fitRank : fitRank + (1.0 - (double)params.ap.nbElite / (double)pop->size()) * divRank;
+			}
+			if ((*pop)[referenceRanking[i].second]->biasedFitness != referenceBiasedFitness)
+				throw std::string("Incorrect biased fitness of individual " + std::to_string(referenceRanking[i].second) + context);
+		}
+	}
+}
+
+Population::Population(Params & params, Split & split, LocalSearch & localSearch) : params(params), split(split), localSearch(localSearch),
+	feasibilityLoad(params.ap.nbIterPenaltyManagement), feasibilityDuration(params.ap.nbIterPenaltyManagement), bestSolutionRestart(params), bestSolutionOverall(params)
+{
+	for (ProximityStructure * proximity : { &feasibleProximity, &infeasibleProximity })
+	{
+		proximity->nbSlots = params.ap.mu + params.ap.lambda + 1; // Maximum size of a subpopulation, before the survivor selection
+		proximity->distances = std::vector <double>(proximity->nbSlots * proximity->nbSlots);
+		for (int slot = proximity->nbSlots - 1; slot >= 0; slot--) proximity->freeSlots.push_back(slot);
+		proximity->closest = std::vector < std::vector < std::pair <double, int> > >(proximity->nbSlots);
+		for (std::vector < std::pair <double, int> > & closest : proximity->closest) closest.reserve(params.ap.nbClose + 1);
+		proximity->nbClones = std::vector <int>(proximity->nbSlots);
+	}
+
+	// One individual of the pool per slot of the two subpopulations, so that the pool never runs out (copies, which do not draw random numbers)
+	for (int i = 0; i < feasibleProximity.nbSlots + infeasibleProximity.nbSlots; i++) freeIndividuals.push_back(new Individual(bestSolutionOverall));
+	distancesToSort.reserve(feasibleProximity.nbSlots);
+	ranking.reserve(feasibleProximity.nbSlots);
+	isFeasibleSubpopModified = true;
+	isInfeasibleSubpopModified = true;
 }
 
 Population::~Population()
 {
 	for (int i = 0; i < (int)feasibleSubpop.size(); i++) delete feasibleSubpop[i];
 	for (int i = 0; i < (int)infeasibleSubpop.size(); i++) delete infeasibleSubpop[i];
+	for (int i = 0; i < (int)freeIndividuals.size(); i++) delete freeIndividuals[i];
 }
\ No newline at end of file
@@ -29,6 +29,38 @@ SOFTWARE.*/
 
 typedef std::vector <Individual*> SubPopulation ;
 
+// Distances between the individuals of a subpopulation, stored in a flat matrix indexed by the slots of the individuals
+struct ProximityStructure
+{
+	int nbSlots;															// Maximum number of individuals in the subpopulation
+	std::vector <double> distances;											// Distance between the individuals of slots s1 and s2, at position s1*nbSlots+s2
+	std::vector <int> freeSlots;											// Slots which are not used by an individual of the subpopulation
+	std::vector < std::vector < std::pair <double, int> > > closest;		// For each slot, the distances and slots of the nbClose closest individuals, by increasing distance
+	std::vector <int> nbClones;												// For each slot, number of other individuals of the subpopulation with the same solution hash
+};
+
+// Feasibility of the last individuals generated by the LS, in a circular buffer with the number of feasible ones (O(1) updates and queries)
+struct FeasibilityHistory
+{
+	std::vector <bool> isFeasible;		// Feasibility of the last individuals, the oldest one being at position pos
+	int pos;							// Position of the oldest individual, replaced by the next one
+	int nbFeasible;						// Number of feasible individuals in the buffer
+
+	// Replaces the oldest individual by a new one
+	void add(bool isNewFeasible)
+	{
+		nbFeasible += (int)isNewFeasible - (int)isFeasible[pos];
+		isFeasible[pos] = isNewFeasible;
+		pos = (pos + 1) % (int)isFeasible.size();
+	}
+
+	// Fraction of feasible individuals
+	double fractionFeasible() const { return (double)nbFeasible / (double)isFeasible.size(); }
+
+	// Creates a buffer of the given size, considering initially that all individuals are feasible
+	FeasibilityHistory(int size) : isFeasible(size, true), pos(0), nbFeasible(size) {}
+};
+
 class Population
 {
    private:
@@ -38,13 +70,32 @@ class Population
    LocalSearch & localSearch;					// Local search structure
    SubPopulation feasibleSubpop;			    // Feasible subpopulation, kept ordered by increasing penalized cost
    SubPopulation infeasibleSubpop;		        // Infeasible subpopulation, kept ordered by increasing penalized cost
-   std::list <bool> listFeasibilityLoad ;		// Load feasibility of recent individuals generated by LS
-   std::list <bool> listFeasibilityDuration ;	// Duration feasibility of recent individuals generated by LS
+   FeasibilityHistory feasibilityLoad ;		// Load feasibility of recent individuals generated by LS
+   FeasibilityHistory feasibilityDuration ;	// Duration feasibility of recent individuals generated by LS
    std::vector<std::pair<clock_t, double>> searchProgress; // Keeps tracks of the time stamps of successive best solutions
    Individual bestSolutionRestart;              // Best solution found during the current restart of the algorithm
    Individual bestSolutionOverall;              // Best solution found during the complete execution of the algorithm
+   bool isFeasibleSubpopModified;               // Tells whether the feasible subpopulation has changed since the last calculation of its biased fitnesses
+   bool isInfeasibleSubpopModified;             // Tells whether the infeasible subpopulation has changed (members or order) since the last calculation of its biased fitnesses
+   ProximityStructure feasibleProximity;        // Distances between the individuals of the feasible subpopulation
+   ProximityStructure infeasibleProximity;      // Distances between the individuals of the infeasible subpopulation
+   std::vector < std::pair <double, int> > distancesToSort;	// Temporary list of distances, used to find the closest individuals
+   std::vector < std::pair <double, int> > ranking;			// Temporary ranking of the individuals by diversity contribution, used to calculate the biased fitnesses
+   std::vector <Individual*> freeIndividuals;	// Pool of individuals which are not in the population, recycled by addIndividual to avoid any allocation once their vectors have grown
+
+   // Proximity structure of the given subpopulation
+   ProximityStructure & getProximity(const SubPopulation & pop) { return (&pop == &feasibleSubpop) ? feasibleProximity : infeasibleProximity; }
 
-   // Evaluates the biased fitness of all individuals in the population
+   // Fills the list of closest individuals of an individual from the distances of the proximity structure, and updates its diversity contribution
+   void updateClosest(const SubPopulation & pop, Individual & indiv);
+
+   // Inserts an individual at the given distance in the list of closest individuals of indiv if it is close enough, and updates its diversity contribution
+   void insertClosest(ProximityStructure & proximity, Individual & indiv, double distance, int slot);
+
+   // Flag telling whether the biased fitnesses of the given subpopulation must be calculated again
+   bool & isModified(const SubPopulation & pop) { return (&pop == &feasibleSubpop) ? isFeasibleSubpopModified : isInfeasibleSubpopModified; }
+
+   // Evaluates the biased fitness of all individuals in the population, if it has changed since the last evaluation
    void updateBiasedFitnesses(SubPopulation & pop);
 
    // Removes the worst individual in terms of biased fitness
@@ -77,14 +128,17 @@ class Population
    // Accesses the best found solution at all time
    const Individual * getBestFound();
 
-   // Prints population state
+   // Prints population state (and the statistics of the phases of the algorithm if params.ap.printStatistics is set)
    void printState(int nbIter, int nbIterNoImprovement);
 
+   // Statistics of the phases of the algorithm since its start
+   Statistics getStatistics();
+
    // Distance measure between two individuals, used for diversity calculations
    double brokenPairsDistance(const Individual & indiv1, const Individual & indiv2);
 
-   // Returns the average broken pairs distance of this individual with the nbClosest individuals in the population
-   double averageBrokenPairsDistanceClosest(const Individual & indiv, int nbClosest);
+   // Returns the average broken pairs distance of this individual with the nbClosest individuals in its subpopulation
+   double averageBrokenPairsDistanceClosest(const SubPopulation & pop, const Individual & indiv, int nbClosest);
 
    // Returns the average diversity value among the 50% best individuals in the subpopulation
    double getDiversity(const SubPopulation & pop);
@@ -95,9 +149,20 @@ class Population
    // Exports in a file the history of solution improvements
    void exportSearchProgress(std::string fileName, std::string instanceName);
 
+   // Exports in a file the statistics of the phases of the algorithm, in JSON format
+   void exportStatistics(std::string fileName);
+
+   // Exports in a file the events kept in the trace buffers, in Chrome trace format (JSON, viewable with chrome://tracing or Perfetto)
+   // Precondition: the threads of the local search are idle (no search in progress)
+   void exportTrace(std::string fileName);
+
    // Exports an Individual in CVRPLib format
    void exportCVRPLibFormat(const Individual & indiv, std::string fileName);
 
+   // Compares the data cached by the subpopulations with a complete recalculation (used by the tests), throwing a description of the first inconsistency found
+   // The biased fitnesses are first updated, as done before using them
+   void checkSubpopulations();
+
    // Constructor
    Population(Params & params, Split & split, LocalSearch & localSearch);
 
@@ -2,6 +2,9 @@
 
 void Split::generalSplit(Individual & indiv, int nbMaxVehicles)
 {
+	PhaseTimer timer(params.stats.timeSplit, params.traceBuffers[0], "Split");
+	params.stats.nbSplits++;
+
 	// Do not apply Split with fewer vehicles than the trivial (LP) bin packing bound
 	maxVehicles = std::max<int>(nbMaxVehicles, std::ceil(params.totalDemand/params.vehicleCapacity));
 
@@ -9,20 +12,26 @@ void Split::generalSplit(Individual & indiv, int nbMaxVehicles)
 	// Direct application of the code located at https://github.com/vidalt/Split-Library
 	for (int i = 1; i <= params.nbClients; i++)
 	{
-		cliSplit[i].demand = params.cli[indiv.chromT[i - 1]].demand;
-		cliSplit[i].serviceTime = params.cli[indiv.chromT[i - 1]].serviceDuration;
-		cliSplit[i].d0_x = params.timeCost[0][indiv.chromT[i - 1]];
-		cliSplit[i].dx_0 = params.timeCost[indiv.chromT[i - 1]][0];
-		if (i < params.nbClients) cliSplit[i].dnext = params.timeCost[indiv.chromT[i - 1]][indiv.chromT[i]];
-		else cliSplit[i].dnext = -1.e30;
-		sumLoad[i] = sumLoad[i - 1] + cliSplit[i].demand;
-		sumService[i] = sumService[i - 1] + cliSplit[i].serviceTime;
-		sumDistance[i] = sumDistance[i - 1] + cliSplit[i - 1].dnext;
+		cliSplit.demand[i] = clientDemand[indiv.chromT[i - 1]];
+		cliSplit.serviceTime[i] = clientService[indiv.chromT[i - 1]];
+		cliSplit.d0_x[i] = params.timeCost[0][indiv.chromT[i - 1]];
+		cliSplit.dx_0[i] = clientToDepot[indiv.chromT[i - 1]];
+		if (i < params.nbClients) cliSplit.dnext[i] = params.timeCost[indiv.chromT[i - 1]][indiv.chromT[i]];
+		else cliSplit.dnext[i] = -1.e30;
+		sumLoad[i] = sumLoad[i - 1] + cliSplit.demand[i];
+		sumService[i] = sumService[i - 1] + cliSplit.serviceTime[i];
+		sumDistance[i] = sumDistance[i - 1] + cliSplit.dnext[i - 1];
 	}
 
+	// With duration constraints, the Bellman algorithm is only needed if the distances along the giant tour violate the triangle inequality
+	isDurationMonotone = params.isDurationConstraint && checkDurationMonotone();
+
 	// We first try the simple split, and then the Split with limited fleet if this is not successful
 	if (splitSimple(indiv) == 0)
+	{
+		params.stats.nbSplitsLF++;
 		splitLF(indiv);
+	}
 
 	// Build up the rest of the Individual structure
 	indiv.evaluateCompleteCost(params);
@@ -31,13 +40,14 @@ void Split::generalSplit(Individual & indiv, int nbMaxVehicles)
 int Split::splitSimple(Individual & indiv)
 {
 	// Reinitialize the potential structures
-	potential[0][0] = 0;
+	potential[label(0, 0)] = 0;
 	for (int i = 1; i <= params.nbClients; i++)
-		potential[0][i] = 1.e30;
+		potential[label(0, i)] = 1.e30;
 
 	// MAIN ALGORITHM -- Simple Split using Bellman's algorithm in topological order
 	// This code has been maintained as it is very simple and can be easily adapted to a variety of constraints, whereas the O(n) Split has a more restricted application scope
-	if (params.isDurationConstraint)
+	// It is used with duration constraints when the distances along the giant tour violate the triangle inequality
+	if (params.isDurationConstraint && !isDurationMonotone)
 	{
 		for (int i = 0; i < params.nbClients; i++)
 		{
@@ -46,29 +56,31 @@ int Split::splitSimple(Individual & indiv)
 			double serviceDuration = 0.;
 			for (int j = i + 1; j <= params.nbClients && load <= 1.5 * params.vehicleCapacity ; j++)
 			{
-				load += cliSplit[j].demand;
-				serviceDuration += cliSplit[j].serviceTime;
-				if (j == i + 1) distance += cliSplit[j].d0_x;
-				else distance += cliSplit[j - 1].dnext;
-				double cost = distance + cliSplit[j].dx_0
+				load += cliSplit.demand[j];
+				serviceDuration += cliSplit.serviceTime[j];
+				if (j == i + 1) distance += cliSplit.d0_x[j];
+				else distance += cliSplit.dnext[j - 1];
+				double cost = distance + cliSplit.dx_0[j]
 					+ params.penaltyCapacity * std::max<double>(load - params.vehicleCapacity, 0.)
-					+ params.penaltyDuration * std::max<double>(distance + cliSplit[j].dx_0 + serviceDuration - params.durationLimit, 0.);
-				if (potential[0][i] + cost < potential[0][j])
+					+ params.penaltyDuration * std::max<double>(distance + cliSplit.dx_0[j] + serviceDuration - params.durationLimit, 0.);
+				if (potential[label(0, i)] + cost < potential[label(0, j)])
 				{
-					potential[0][j] = potential[0][i] + cost;
-					pred[0][j] = i;
+					potential[label(0, j)] = potential[label(0, i)] + cost;
+					pred[label(0, j)] = i;
 				}
 			}
 		}
 	}
+	else if (params.isDurationConstraint)
+		propagateWithDuration(0, 0, 0);
 	else
 	{
-		Trivial_Deque queue = Trivial_Deque(params.nbClients + 1, 0);
+		queue.reset(0);
 		for (int i = 1; i <= params.nbClients; i++)
 		{
 			// The front is the best predecessor for i
-			potential[0][i] = propagate(queue.get_front(), i, 0);
-			pred[0][i] = queue.get_front();
+			potential[label(0, i)] = propagate(queue.get_front(), i, 0);
+			pred[label(0, i)] = queue.get_front();
 
 			if (i < params.nbClients)
 			{
@@ -87,20 +99,18 @@ int Split::splitSimple(Individual & indiv)
 		}
 	}
 
-	if (potential[0][params.nbClients] > 1.e29)
+	if (potential[label(0, params.nbClients)] > 1.e29)
 		throw std::string("ERROR : no Split solution has been propagated until the last node");
 
-	// Filling the chromR structure
-	for (int k = params.nbVehicles - 1; k >= maxVehicles; k--)
-		indiv.chromR[k].clear();
+	// Filling the route starts (the routes are the segments of the giant tour)
+	for (int k = params.nbVehicles; k >= maxVehicles; k--)
+		indiv.routeStarts[k] = params.nbClients;
 
 	int end = params.nbClients;
 	for (int k = maxVehicles - 1; k >= 0; k--)
 	{
-		indiv.chromR[k].clear();
-		int begin = pred[0][end];
-		for (int ii = begin; ii < end; ii++)
-			indiv.chromR[k].push_back(indiv.chromT[ii]);
+		int begin = pred[label(0, end)];
+		indiv.routeStarts[k] = begin;
 		end = begin;
 	}
 
@@ -111,44 +121,55 @@ int Split::splitSimple(Individual & indiv)
 // Split for problems with limited fleet
 int Split::splitLF(Individual & indiv)
 {
-	// Initialize the potential structures
-	potential[0][0] = 0;
-	for (int k = 0; k <= maxVehicles; k++)
-		for (int i = 1; i <= params.nbClients; i++)
-			potential[k][i] = 1.e30;
+	// Initialize the potential structures (the rows of the next layers are initialized while propagating the labels)
+	if ((int)potential.size() < label(maxVehicles + 1, 0))
+	{
+		potential.resize(label(maxVehicles + 1, 0));
+		pred.resize(label(maxVehicles + 1, 0));
+	}
+	potential[label(0, 0)] = 0;
+	for (int i = 1; i <= params.nbClients; i++)
+		potential[label(0, i)] = 1.e30;
 
 	// MAIN ALGORITHM -- Simple Split using Bellman's algorithm in topological order
 	// This code has been maintained as it is very simple and can be easily adapted to a variety of constraints, whereas the O(n) Split has a more restricted application scope
-	if (params.isDurationConstraint) 
+	// It is used with duration constraints when the distances along the giant tour violate the triangle inequality
+	if (params.isDurationConstraint && !isDurationMonotone)
 	{
 		for (int k = 0; k < maxVehicles; k++)
 		{
-			for (int i = k; i < params.nbClients && potential[k][i] < 1.e29 ; i++)
+			for (int i = k + 1; i <= params.nbClients; i++)
+				potential[label(k + 1, i)] = 1.e30;
+			for (int i = k; i < params.nbClients && potential[label(k, i)] < 1.e29 ; i++)
 			{
 				double load = 0.;
 				double serviceDuration = 0.;
 				double distance = 0.;
 				for (int j = i + 1; j <= params.nbClients && load <= 1.5 * params.vehicleCapacity ; j++) // Setting a maximum limit on load infeasibility to accelerate the algorithm
 				{
-					load += cliSplit[j].demand;
-					serviceDuration += cliSplit[j].serviceTime;
-					if (j == i + 1) distance += cliSplit[j].d0_x;
-					else distance += cliSplit[j - 1].dnext;
-					double cost = distance + cliSplit[j].dx_0
+					load += cliSplit.demand[j];
+					serviceDuration += cliSplit.serviceTime[j];
+					if (j == i + 1) distance += cliSplit.d0_x[j];
+					else distance += cliSplit.dnext[j - 1];
+					double cost = distance + cliSplit.dx_0[j]
 								+ params.penaltyCapacity * std::max<double>(load - params.vehicleCapacity, 0.)
-								+ params.penaltyDuration * std::max<double>(distance + cliSplit[j].dx_0 + serviceDuration - params.durationLimit, 0.);
-					if (potential[k][i] + cost < potential[k + 1][j])
+								+ params.penaltyDuration * std::max<double>(distance + cliSplit.dx_0[j] + serviceDuration - params.durationLimit, 0.);
+					if (potential[label(k, i)] + cost < potential[label(k + 1, j)])
 					{
-						potential[k + 1][j] = potential[k][i] + cost;
-						pred[k + 1][j] = i;
+						potential[label(k + 1, j)] = potential[label(k, i)] + cost;
+						pred[label(k + 1, j)] = i;
 					}
 				}
 			}
 		}
 	}
+	else if (params.isDurationConstraint)
+	{
+		for (int k = 0; k < maxVehicles; k++)
+			propagateWithDuration(k, k + 1, k);
+	}
 	else // MAIN ALGORITHM -- Without duration constraints in O(n), from "Vidal, T. (2016). Split algorithm in O(n) for the capacitated vehicle routing problem. C&OR"
 	{
-		Trivial_Deque queue = Trivial_Deque(params.nbClients + 1, 0);
 		for (int k = 0; k < maxVehicles; k++)
 		{
 			// in the Split problem there is always one feasible solution with k routes that reaches the index k in the tour.
@@ -156,11 +177,12 @@ int Split::splitLF(Individual & indiv)
 
 			// The range of potentials < 1.29 is always an interval.
 			// The size of the queue will stay >= 1 until we reach the end of this interval.
-			for (int i = k + 1; i <= params.nbClients && queue.size() > 0; i++)
+			int i = k + 1;
+			for (; i <= params.nbClients && queue.size() > 0; i++)
 			{
 				// The front is the best predecessor for i
-				potential[k + 1][i] = propagate(queue.get_front(), i, k);
-				pred[k + 1][i] = queue.get_front();
+				potential[label(k + 1, i)] = propagate(queue.get_front(), i, k);
+				pred[label(k + 1, i)] = queue.get_front();
 
 				if (i < params.nbClients)
 				{
@@ -178,30 +200,32 @@ int Split::splitLF(Individual & indiv)
 						queue.pop_front();
 				}
 			}
+
+			// The labels beyond this interval have not been reached
+			for (; i <= params.nbClients; i++)
+				potential[label(k + 1, i)] = 1.e30;
 		}
 	}
 
-	if (potential[maxVehicles][params.nbClients] > 1.e29)
+	if (potential[label(maxVehicles, params.nbClients)] > 1.e29)
 		throw std::string("ERROR : no Split solution has been propagated until the last node");
 
 	// It could be cheaper to use a smaller number of vehicles
-	double minCost = potential[maxVehicles][params.nbClients];
+	double minCost = potential[label(maxVehicles, params.nbClients)];
 	int nbRoutes = maxVehicles;
 	for (int k = 1; k < maxVehicles; k++)
-		if (potential[k][params.nbClients] < minCost)
-			{minCost = potential[k][params.nbClients]; nbRoutes = k;}
+		if (potential[label(k, params.nbClients)] < minCost)
+			{minCost = potential[label(k, params.nbClients)]; nbRoutes = k;}
 
-	// Filling the chromR structure
-	for (int k = params.nbVehicles-1; k >= nbRoutes ; k--)
-		indiv.chromR[k].clear();
+	// Filling the route starts (the routes are the segments of the giant tour)
+	for (int k = params.nbVehicles; k >= nbRoutes ; k--)
+		indiv.routeStarts[k] = params.nbClients;
 
 	int end = params.nbClients;
 	for (int k = nbRoutes - 1; k >= 0; k--)
 	{
-		indiv.chromR[k].clear();
-		int begin = pred[k+1][end];
-		for (int ii = begin; ii < end; ii++)
-			indiv.chromR[k].push_back(indiv.chromT[ii]);
+		int begin = pred[label(k+1, end)];
+		indiv.routeStarts[k] = begin;
 		end = begin;
 	}
 
@@ -209,13 +233,82 @@ int Split::splitLF(Individual & indiv)
 	return (end == 0);
 }
 
-Split::Split(const Params & params): params(params)
+bool Split::checkDurationMonotone()
+{
+	for (int i = 1; i < params.nbClients; i++)
+		if (durationStart(i) > durationStart(i - 1) + MY_EPSILON || durationEnd(i) > durationEnd(i + 1) + MY_EPSILON)
+			return false;
+	return true;
+}
+
+void Split::propagateWithDuration(int kFrom, int kTo, int firstNode)
+{
+	// Since the cost difference between two predecessors i < j is non-decreasing with the destination node, once j is better than i it remains better
+	// The queue therefore contains the successive best predecessors, each one associated to the first node from which it is the best
+	queue.reset(firstNode);
+	queueStart[0] = firstNode + 1;
+	for (int i = firstNode + 1; i <= params.nbClients; i++)
+	{
+		// Removing the front if the next predecessor of the queue is better from node i onwards
+		while (queue.size() > 1 && queueStart[queue.indexFront + 1] <= i)
+			queue.pop_front();
+
+		potential[label(kTo, i)] = propagate(queue.get_front(), i, kFrom);
+		pred[label(kTo, i)] = queue.get_front();
+
+		if (i < params.nbClients && potential[label(kFrom, i)] < 1.e29)
+		{
+			// Removing the predecessors which are outperformed by i from the first node where they are the best
+			int firstBetter = i + 1;
+			while (queue.size() > 0)
+			{
+				firstBetter = std::max<int>(queueStart[queue.indexBack], i + 1);
+				if (propagate(i, firstBetter, kFrom) < propagate(queue.get_back(), firstBetter, kFrom) + MY_EPSILON)
+					queue.pop_back();
+				else break;
+			}
+
+			// Binary search of the first node for which i is better than the last predecessor of the queue
+			if (queue.size() > 0)
+			{
+				int lowerBound = firstBetter + 1;
+				int upperBound = params.nbClients + 1;
+				while (lowerBound < upperBound)
+				{
+					int middle = (lowerBound + upperBound) / 2;
+					if (propagate(i, middle, kFrom) < propagate(queue.get_back(), middle, kFrom) + MY_EPSILON) upperBound = middle;
+					else lowerBound = middle + 1;
+				}
+				firstBetter = lowerBound;
+			}
+
+			if (firstBetter <= params.nbClients)
+			{
+				queue.push_back(i);
+				queueStart[queue.indexBack] = firstBetter;
+			}
+		}
+	}
+}
+
+Split::Split(const Params & params): params(params), cliSplit(params.nbClients), queue(params.nbClients + 1, 0)
 {
+	// Client data, stored contiguously to avoid accessing the columns of the distance matrix
+	clientDemand = std::vector <double>(params.nbClients + 1, 0.);
+	clientService = std::vector <double>(params.nbClients + 1, 0.);
+	clientToDepot = std::vector <double>(params.nbClients + 1, 0.);
+	for (int i = 1; i <= params.nbClients; i++)
+	{
+		clientDemand[i] = params.cli[i].demand;
+		clientService[i] = params.cli[i].serviceDuration;
+		clientToDepot[i] = params.timeCost[i][0];
+	}
+
 	// Structures of the linear Split
-	cliSplit = std::vector <ClientSplit>(params.nbClients + 1);
 	sumDistance = std::vector <double>(params.nbClients + 1,0.);
 	sumLoad = std::vector <double>(params.nbClients + 1,0.);
 	sumService = std::vector <double>(params.nbClients + 1, 0.);
-	potential = std::vector < std::vector <double> >(params.nbVehicles + 1, std::vector <double>(params.nbClients + 1,1.e30));
-	pred = std::vector < std::vector <int> >(params.nbVehicles + 1, std::vector <int>(params.nbClients + 1,0));
+	queueStart = std::vector <int>(params.nbClients + 1, 0);
+	potential = std::vector <double>(params.nbClients + 1, 1.e30); // Only the first row is allocated, the next ones are allocated when needed by the Split with limited fleet
+	pred = std::vector <int>(params.nbClients + 1, 0);
 }
@@ -26,14 +26,15 @@ SOFTWARE.*/
 #include "Params.h"
 #include "Individual.h"
 
+// Data of the clients in the order of the giant tour, stored as a structure of arrays so that each Split loop only reads the arrays it needs
 struct ClientSplit
 {
-	double demand;
-	double serviceTime;
-	double d0_x;
-	double dx_0;
-	double dnext;
-	ClientSplit() : demand(0.), serviceTime(0.), d0_x(0.), dx_0(0.), dnext(0.) {};
+	std::vector <double> demand;
+	std::vector <double> serviceTime;
+	std::vector <double> d0_x;
+	std::vector <double> dx_0;
+	std::vector <double> dnext;
+	ClientSplit(int nbClients) : demand(nbClients + 1, 0.), serviceTime(nbClients + 1, 0.), d0_x(nbClients + 1, 0.), dx_0(nbClients + 1, 0.), dnext(nbClients + 1, 0.) {};
 };
 
 // Simple Deque which is used for all Linear Split algorithms
@@ -68,28 +69,42 @@ class Split
  // Problem parameters
  const Params & params ;
  int maxVehicles ;
+ bool isDurationMonotone ; // Tells whether the route durations along the current giant tour have the monotonicity properties used by the Split with duration penalties
 
  /* Auxiliary data structures to run the Linear Split algorithm */
- std::vector < ClientSplit > cliSplit;
- std::vector < std::vector < double > > potential;  // Potential vector
- std::vector < std::vector < int > > pred;  // Indice of the predecessor in an optimal path
+ ClientSplit cliSplit;
+ Trivial_Deque queue; // Queue of the linear Split algorithms, allocated once
+ std::vector <double> clientDemand; // Demand of each client, copied contiguously from params
+ std::vector <double> clientService; // Service duration of each client, copied contiguously from params
+ std::vector <double> clientToDepot; // Distance from each client to the depot (column of the distance matrix, copied contiguously)
+ std::vector < double > potential;  // Potential vector, stored row by row for each number of vehicles (see label)
+ std::vector < int > pred;  // Indice of the predecessor in an optimal path, stored as the potentials
  std::vector <double> sumDistance; // sumDistance[i] for i > 1 contains the sum of distances : sum_{k=1}^{i-1} d_{k,k+1}
  std::vector <double> sumLoad; // sumLoad[i] for i >= 1 contains the sum of loads : sum_{k=1}^{i} q_k
  std::vector <double> sumService; // sumService[i] for i >= 1 contains the sum of service time : sum_{k=1}^{i} s_k
+ std::vector <int> queueStart; // For each element of the queue, first node for which this predecessor is the best (Split with duration penalties)
+
+ // Index of the label of node i with k vehicles in the potential and pred vectors
+ inline int label(int k, int i) {return k * (params.nbClients + 1) + i;}
+
+ // Duration of the route visiting the clients i+1...j of the giant tour, decomposed as durationStart(i) + durationEnd(j)
+ inline double durationStart(int i) {return cliSplit.d0_x[i + 1] - sumDistance[i + 1] - sumService[i];}
+ inline double durationEnd(int j) {return sumDistance[j] + sumService[j] + cliSplit.dx_0[j];}
 
  // To be called with i < j only
  // Computes the cost of propagating the label i until j
  inline double propagate(int i, int j, int k)
  {
-	 return potential[k][i] + sumDistance[j] - sumDistance[i + 1] + cliSplit[i + 1].d0_x + cliSplit[j].dx_0
-		 + params.penaltyCapacity * std::max<double>(sumLoad[j] - sumLoad[i] - params.vehicleCapacity, 0.);
+	 return potential[label(k, i)] + sumDistance[j] - sumDistance[i + 1] + cliSplit.d0_x[i + 1] + cliSplit.dx_0[j]
+		 + params.penaltyCapacity * std::max<double>(sumLoad[j] - sumLoad[i] - params.vehicleCapacity, 0.)
+		 + (params.isDurationConstraint ? params.penaltyDuration * std::max<double>(durationStart(i) + durationEnd(j) - params.durationLimit, 0.) : 0.);
  }
 
  // Tests if i dominates j as a predecessor for all nodes x >= j+1
  // We assume that i < j
  inline bool dominates(int i, int j, int k)
  {
-	 return potential[k][j] + cliSplit[j + 1].d0_x > potential[k][i] + cliSplit[i + 1].d0_x + sumDistance[j + 1] - sumDistance[i + 1]
+	 return potential[label(k, j)] + cliSplit.d0_x[j + 1] > potential[label(k, i)] + cliSplit.d0_x[i + 1] + sumDistance[j + 1] - sumDistance[i + 1]
 		 + params.penaltyCapacity * (sumLoad[j] - sumLoad[i]);
  }
 
@@ -97,9 +112,17 @@ class Split
  // We assume that i < j
  inline bool dominatesRight(int i, int j, int k)
  {
-	 return potential[k][j] + cliSplit[j + 1].d0_x < potential[k][i] + cliSplit[i + 1].d0_x + sumDistance[j + 1] - sumDistance[i + 1] + MY_EPSILON;
+	 return potential[label(k, j)] + cliSplit.d0_x[j + 1] < potential[label(k, i)] + cliSplit.d0_x[i + 1] + sumDistance[j + 1] - sumDistance[i + 1] + MY_EPSILON;
  }
 
+ // Checks whether durationStart is non-increasing and durationEnd is non-decreasing, which holds whenever the distances along the giant tour satisfy the triangle inequality
+ // In that case, for two predecessors i < j, the cost difference between propagating i and j is non-decreasing with the destination node
+ bool checkDurationMonotone();
+
+ // Propagates the labels of layer kFrom (starting from firstNode) towards layer kTo with capacity and duration penalties, in O(n log n)
+ // Each candidate predecessor is kept with the first node from which it becomes the best predecessor, found by binary search
+ void propagateWithDuration(int kFrom, int kTo, int firstNode);
+
   // Split for unlimited fleet
   int splitSimple(Individual & indiv);
 
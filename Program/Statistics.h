@@ -0,0 +1,40 @@
+// This header file must be readable in C.
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#define NB_MOVE_TYPES 10 // Index 0 for the SWAP* moves, indices 1 to 9 for the moves move1 to move9 of the local search
+
+// Counters and times (wall-clock, in seconds) of the phases of the algorithm, collected during the complete execution
+struct Statistics {
+	double time;						// Total time since the start of the algorithm
+	int nbIterations;					// Number of iterations of the genetic algorithm (all restarts included)
+
+	long long nbCrossovers;				// Number of crossovers
+	double timeCrossover;				// Time spent in the crossovers, excluding the Split of the offspring
+
+	long long nbSplits;					// Number of applications of Split
+	long long nbSplitsLF;				// Number of applications of Split which needed the Split with limited fleet (fallback of the simple Split)
+	double timeSplit;					// Time spent in Split
+
+	long long nbLocalSearches;			// Number of calls to the local search (run)
+	long long nbLoopsLS;				// Number of loops over all nodes and routes of the local search (including the repairs)
+	double timeLocalSearch;				// Time spent in the local search, including all resumed searches (also the ones of the repairs)
+	long long nbMoveEvaluations[NB_MOVE_TYPES];	// Number of evaluations of each move type (see NB_MOVE_TYPES)
+	long long nbMoveSuccesses[NB_MOVE_TYPES];	// Number of improving moves applied for each move type
+
+	long long nbRepairs;				// Number of repairs of infeasible solutions
+	double timeRepair;					// Time spent in the repairs, until their first interruption if any
+
+	long long nbInsertions;				// Number of individuals added to the population
+	double timePopulation;				// Time spent in the population management (insertions, survivor selection and selection of the parents)
+	long long nbBrokenPairsDistances;	// Number of broken pairs distances calculated
+
+	long long nbPenaltyUpdates;			// Number of adaptations of the penalty parameters
+	double timePenaltyUpdates;			// Time spent in the adaptations of the penalty parameters
+
+	long long nbRouteCacheLookups;		// Number of routes searched in the cache of route evaluations
+	long long nbRouteCacheHits;			// Number of routes found in the cache of route evaluations
+};
+
+#endif //STATISTICS_H
@@ -0,0 +1,46 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <vector>
+#include <chrono>
+
+// Wall-clock time in seconds, used to measure the phases of the algorithm (cheaper than clock(), and not inflated by the other threads)
+inline double wallClock() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+// Phase of the algorithm executed by a thread, from startTime to endTime (wall-clock)
+struct TraceEvent
+{
+	const char * name;			// Name of the phase (string literal)
+	double startTime;
+	double endTime;
+};
+
+// Ring buffer of the last events of one thread. Only its thread writes in it, and it is read once the thread is idle (after the search), so no synchronization is needed
+struct TraceBuffer
+{
+	std::vector < TraceEvent > events;	// Last events, event number k being stored at position k % events.size(). Empty if the trace is inactive
+	long long nbEvents;					// Number of events recorded since the start (the oldest ones have been overwritten if larger than events.size())
+
+	bool isActive() const { return !events.empty(); }
+
+	void add(const char * name, double startTime, double endTime)
+	{
+		if (events.empty()) return;
+		events[nbEvents % (long long)events.size()] = { name, startTime, endTime };
+		nbEvents++;
+	}
+
+	TraceBuffer(int size) : events(size), nbEvents(0) {}
+};
+
+// Records in a trace buffer the phase executed between its construction and its destruction (without reading the clock if the trace is inactive)
+struct TraceScope
+{
+	TraceBuffer & traceBuffer;
+	const char * name;
+	double startTime;
+	TraceScope(TraceBuffer & traceBuffer, const char * name) : traceBuffer(traceBuffer), name(name), startTime(traceBuffer.isActive() ? wallClock() : 0.) {}
+	~TraceScope() { if (traceBuffer.isActive()) traceBuffer.add(name, startTime, wallClock()); }
+};
+
+#endif
@@ -36,13 +36,14 @@ public:
 	int nbVeh		 = INT_MAX;		// Number of vehicles. Default value: infinity
 	std::string pathInstance;		// Instance path
 	std::string pathSolution;		// Solution path
+	std::string pathStatistics;		// Path of the statistics exported with -stats. Default value: solution path followed by .stats.json
 	bool verbose     = true;
 	bool isRoundingInteger = true;
 
 	// Reads the line of command and extracts possible options
 	CommandLine(int argc, char* argv[])
 	{
-		if (argc % 2 != 1 || argc > 35 || argc < 3)
+		if (argc % 2 != 1 || argc > 59 || argc < 3)
 		{
 			std::cout << "----- NUMBER OF COMMANDLINE ARGUMENTS IS INCORRECT: " << argc << std::endl;
 			display_help(); throw std::string("Incorrect line of command");
@@ -51,6 +52,7 @@ public:
 		{
 			pathInstance = std::string(argv[1]);
 			pathSolution = std::string(argv[2]);
+			pathStatistics = pathSolution + ".stats.json";
 			for (int i = 3; i < argc; i += 2)
 			{
 				if (std::string(argv[i]) == "-t")
@@ -85,6 +87,30 @@ public:
 					ap.penaltyIncrease = atof(argv[i+1]);
 				else if (std::string(argv[i]) == "-penaltyDecrease")
 					ap.penaltyDecrease = atof(argv[i+1]);
+				else if (std::string(argv[i]) == "-maxMovesLS")
+					ap.maxMovesLS = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-timeLimitLS")
+					ap.timeLimitLS = atof(argv[i+1]);
+				else if (std::string(argv[i]) == "-nbThreadsLS")
+					ap.nbThreadsLS = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-nbIterDecomposition")
+					ap.nbIterDecomposition = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-sizeDecomposition")
+					ap.sizeDecomposition = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-timeLimitDecomposition")
+					ap.timeLimitDecomposition = atof(argv[i+1]);
+				else if (std::string(argv[i]) == "-nbCoarseningLevels")
+					ap.nbCoarseningLevels = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-nbRecentGiantTours")
+					ap.nbRecentGiantTours = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-routeCacheSize")
+					ap.routeCacheSize = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-stats")
+					ap.printStatistics = atoi(argv[i+1]);
+				else if (std::string(argv[i]) == "-statsFile")
+					pathStatistics = std::string(argv[i+1]);
+				else if (std::string(argv[i]) == "-trace")
+					ap.traceSize = atoi(argv[i+1]);
 				else
 				{
 					std::cout << "----- ARGUMENT NOT RECOGNIZED: " << std::string(argv[i]) << std::endl;
@@ -118,6 +144,18 @@ public:
 		std::cout << "[-targetFeasible <double>] target ratio of feasible individuals between penalty updates. Defaults to 0.2                        " << std::endl;
 		std::cout << "[-penaltyIncrease <double>] penalty increase if insufficient feasible individuals between penalty updates. Defaults to 1.2      " << std::endl;
 		std::cout << "[-penaltyDecrease <double>] penalty decrease if sufficient feasible individuals between penalty updates. Defaults to 0.85       " << std::endl;
+		std::cout << "[-maxMovesLS <int>] maximum number of moves of one local search call before it is interrupted and resumed. Defaults to 0 (none)" << std::endl;
+		std::cout << "[-timeLimitLS <double>] time limit in seconds of one local search call before it is interrupted and resumed. Defaults to 0 (none)" << std::endl;
+		std::cout << "[-nbThreadsLS <int>] number of threads improving groups of neighboring routes in parallel in the local search. Defaults to 1      " << std::endl;
+		std::cout << "[-nbIterDecomposition <int>] iterations between phases solving subproblems of the best solution in parallel. Defaults to 0 (none)" << std::endl;
+		std::cout << "[-sizeDecomposition <int>] target number of customers of each subproblem of the decomposition phases. Defaults to 300       " << std::endl;
+		std::cout << "[-timeLimitDecomposition <double>] CPU time limit in seconds for each subproblem of a decomposition phase. Defaults to 5  " << std::endl;
+		std::cout << "[-nbCoarseningLevels <int>] levels of merged customer pairs in the multilevel mode (HGS on the coarsest level). Defaults to 0 " << std::endl;
+		std::cout << "[-nbRecentGiantTours <int>] recent offspring giant tours memorized to skip the Split and LS of duplicates. Defaults to 0 (none)" << std::endl;
+		std::cout << "[-routeCacheSize <int>] entries of the cache of route evaluations, indexed by route hash. Defaults to 0 (no cache)           " << std::endl;
+		std::cout << "[-stats <bool>] prints phase counters and times with the traces, and exports them in <solPath>.stats.json. Defaults to 0 " << std::endl;
+		std::cout << "[-statsFile <path>] path of the statistics exported with -stats 1, instead of <solPath>.stats.json                          " << std::endl;
+		std::cout << "[-trace <int>] number of phase events kept per thread, exported as a Chrome trace in <solPath>.trace.json. Defaults to 0 " << std::endl;
 		std::cout << "--------------------------------------------------------------------------------------------------------------------------------" << std::endl;
 		std::cout << std::endl;
 	};
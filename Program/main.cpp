@@ -32,6 +32,8 @@ int main(int argc, char *argv[])
 			if (params.verbose) std::cout << "----- WRITING BEST SOLUTION IN : " << commandline.pathSolution << std::endl;
 			solver.population.exportCVRPLibFormat(*solver.population.getBestFound(),commandline.pathSolution);
 			solver.population.exportSearchProgress(commandline.pathSolution + ".PG.csv", commandline.pathInstance);
+			if (params.ap.printStatistics) solver.population.exportStatistics(commandline.pathStatistics);
+			if (params.ap.traceSize > 0) solver.population.exportTrace(commandline.pathSolution + ".trace.json");
 		}
 	}
 	catch (const string& e) { std::cout << "EXCEPTION | " << e << std::endl; }
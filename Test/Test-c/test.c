@@ -15,6 +15,7 @@ void print_solution(struct Solution * sol) {
 	printf("Total Route Cost = %f\n", sol->cost);
 	printf("Total CPU Time = %f\n", sol->time);
 	printf("Number of Routes = %d\n", sol->n_routes);
+	printf("Iterations = %d, Local Searches = %lld, Local Search Time = %f\n", sol->stats.nbIterations, sol->stats.nbLocalSearches, sol->stats.timeLocalSearch);
 	for (int i = 0; i < sol->n_routes; i++) {
 		struct SolutionRoute r = sol->routes[i];
 		printf("Route #%d: ", i);
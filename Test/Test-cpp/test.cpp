@@ -0,0 +1,844 @@
+//
+// Tests of the internal components of HGS (Split and LocalSearch) on CVRPLib instances
+// Call with: lib_test_cpp instanceDirectory
+//
+
+#include "Split.h"
+#include "LocalSearch.h"
+#include "Genetic.h"
+#include "InstanceCVRPLIB.h"
+#include <climits>
+#include <cstdlib>
+#include <new>
+
+int nbFailures = 0;
+
+// Number of heap allocations since the start of the program, counted by the replacement of the global operator new below
+long long nbAllocations = 0;
+
+void * operator new(std::size_t size)
+{
+	nbAllocations++;
+	void * pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == NULL) throw std::bad_alloc();
+	return pointer;
+}
+
+void operator delete(void * pointer) noexcept { std::free(pointer); }
+void operator delete(void * pointer, std::size_t) noexcept { std::free(pointer); }
+
+void check(bool condition, const std::string & message)
+{
+	if (!condition)
+	{
+		std::cout << "FAILED: " << message << std::endl;
+		nbFailures++;
+	}
+}
+
+// Default parameters of the algorithm, with a fixed seed
+AlgorithmParameters testParameters()
+{
+	AlgorithmParameters ap = default_algorithm_parameters();
+	ap.seed = 1;
+	return ap;
+}
+
+// Parameters of a CVRPLib instance with an automatic fleet size and without display. The instance must outlive them, as they refer to its distance matrix
+Params makeParams(const InstanceCVRPLIB & cvrp, const AlgorithmParameters & ap)
+{
+	return Params(cvrp.x_coords, cvrp.y_coords, cvrp.dist_mtx, cvrp.service_time, cvrp.demands,
+		cvrp.vehicleCapacity, cvrp.durationLimit, INT_MAX, cvrp.isDurationConstraint, false, ap);
+}
+
+// Optimal penalized cost of the segmentation of a giant tour into at most maxVehicles routes, by Bellman's algorithm without any speed-up
+double referenceSplitCost(const Params & params, const std::vector<int> & chromT, int maxVehicles)
+{
+	int n = params.nbClients;
+	std::vector < std::vector <double> > potential(maxVehicles + 1, std::vector <double>(n + 1, 1.e30));
+	potential[0][0] = 0.;
+	for (int k = 0; k < maxVehicles; k++)
+	{
+		for (int i = k; i < n; i++)
+		{
+			if (potential[k][i] > 1.e29) continue;
+			double load = 0.;
+			double service = 0.;
+			double distance = 0.;
+			for (int j = i + 1; j <= n; j++)
+			{
+				load += params.cli[chromT[j - 1]].demand;
+				service += params.cli[chromT[j - 1]].serviceDuration;
+				distance += (j == i + 1) ? params.timeCost[0][chromT[j - 1]] : params.timeCost[chromT[j - 2]][chromT[j - 1]];
+				double routeDistance = distance + params.timeCost[chromT[j - 1]][0];
+				double cost = routeDistance
+					+ params.penaltyCapacity * std::max<double>(load - params.vehicleCapacity, 0.)
+					+ params.penaltyDuration * std::max<double>(routeDistance + service - params.durationLimit, 0.);
+				potential[k + 1][j] = std::min<double>(potential[k + 1][j], potential[k][i] + cost);
+			}
+		}
+	}
+	double bestCost = 1.e30;
+	for (int k = 1; k <= maxVehicles; k++) bestCost = std::min<double>(bestCost, potential[k][n]);
+	return bestCost;
+}
+
+// Checks that indiv visits each client exactly once and that its evaluation is consistent with its routes
+// The routes must be consecutive segments of the giant tour, consistent with the successors and predecessors
+void checkSolution(const Params & params, const Individual & indiv, const std::string & context)
+{
+	check((int)indiv.chromT.size() == params.nbClients && indiv.routeStarts[0] == 0 && indiv.routeStarts[params.nbVehicles] == params.nbClients, context + ": routes not covering the giant tour");
+	int nbRoutes = 0;
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		RouteSequence route = indiv.route(r);
+		check(route.size() >= 0, context + ": route " + std::to_string(r) + " ends before its start");
+		if (route.size() <= 0) continue;
+		nbRoutes++;
+		for (int j = 0; j < route.size(); j++)
+			check(indiv.predecessors[route[j]] == (j == 0 ? 0 : route[j - 1]) && indiv.successors[route[j]] == (j == route.size() - 1 ? 0 : route[j + 1]),
+				context + ": successor or predecessor of client " + std::to_string(route[j]) + " not matching its route");
+	}
+	check(indiv.eval.nbRoutes == nbRoutes, context + ": incorrect number of routes");
+
+	std::vector <int> nbVisits(params.nbClients + 1, 0);
+	for (int r = 0; r < params.nbVehicles; r++)
+		for (int client : indiv.route(r)) nbVisits[client]++;
+	for (int i = 1; i <= params.nbClients; i++)
+		check(nbVisits[i] == 1, context + ": client " + std::to_string(i) + " is visited " + std::to_string(nbVisits[i]) + " times");
+	Individual evaluated = indiv;
+	evaluated.evaluateCompleteCost(params);
+	check(std::fabs(evaluated.eval.penalizedCost - indiv.eval.penalizedCost) < 1.e-6 * std::max<double>(1., indiv.eval.penalizedCost), context + ": inconsistent evaluation");
+}
+
+// The Split algorithms (including the Split with duration penalties) must return an optimal segmentation of random giant tours
+void testSplitOptimality(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	Split split(params);
+	int maxVehicles = std::max<int>(params.nbVehicles, std::ceil(params.totalDemand / params.vehicleCapacity));
+	double basePenaltyCapacity = params.penaltyCapacity;
+	double basePenaltyDuration = params.penaltyDuration;
+	for (double multiplier : {1., 10., 100.})
+	{
+		params.penaltyCapacity = basePenaltyCapacity * multiplier;
+		params.penaltyDuration = basePenaltyDuration * multiplier;
+		for (int i = 0; i < 20; i++)
+		{
+			Individual indiv(params);
+			split.generalSplit(indiv, params.nbVehicles);
+			checkSolution(params, indiv, "Split on " + instancePath);
+			double referenceCost = referenceSplitCost(params, indiv.chromT, maxVehicles);
+			check(std::fabs(indiv.eval.penalizedCost - referenceCost) < 1.e-6 * std::max<double>(1., referenceCost),
+				"Split on " + instancePath + " returns " + std::to_string(indiv.eval.penalizedCost) + " instead of " + std::to_string(referenceCost));
+		}
+	}
+}
+
+// Tells whether two individuals have the same routes, in the same order
+bool haveSameRoutes(const Individual & indiv1, const Individual & indiv2)
+{
+	return indiv1.routeStarts == indiv2.routeStarts && indiv1.chromT == indiv2.chromT;
+}
+
+// Cost of a solution with the given penalty values
+double penalizedCost(const Individual & indiv, double penaltyCapacity, double penaltyDuration)
+{
+	return indiv.eval.distance + penaltyCapacity * indiv.eval.capacityExcess + penaltyDuration * indiv.eval.durationExcess;
+}
+
+// The repair of infeasible local minima continues the search in place: it must return a valid solution which does not deteriorate the cost with the repair penalties
+void testRepair(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	Split split(params);
+	LocalSearch localSearch(params);
+	int nbRepairs = 0;
+	for (int i = 0; i < 20; i++)
+	{
+		// Low penalties during the first search, to obtain infeasible solutions
+		Individual indiv(params);
+		split.generalSplit(indiv, params.nbVehicles);
+		localSearch.run(indiv, 0.1 * params.penaltyCapacity, 0.1 * params.penaltyDuration);
+		checkSolution(params, indiv, "Local search on " + instancePath);
+		if (indiv.eval.isFeasible) continue;
+
+		double costBeforeRepair = penalizedCost(indiv, 10. * params.penaltyCapacity, 10. * params.penaltyDuration);
+		localSearch.repair(indiv, 10. * params.penaltyCapacity, 10. * params.penaltyDuration);
+		checkSolution(params, indiv, "Repair on " + instancePath);
+		check(penalizedCost(indiv, 10. * params.penaltyCapacity, 10. * params.penaltyDuration) < costBeforeRepair + MY_EPSILON, "Repair on " + instancePath + " deteriorates the solution");
+		nbRepairs++;
+
+		// The repair only applies to the solution of the last search
+		Individual otherIndiv(params);
+		split.generalSplit(otherIndiv, params.nbVehicles);
+		bool isRejected = false;
+		try { localSearch.repair(otherIndiv, 10. * params.penaltyCapacity, 10. * params.penaltyDuration); }
+		catch (const std::string &) { isRejected = true; }
+		check(isRejected, "Repair on " + instancePath + " accepts a solution which is not the one of the last search");
+	}
+	check(nbRepairs > 0, "No infeasible solution to repair on " + instancePath);
+}
+
+// A search interrupted by its budget (-maxMovesLS or -timeLimitLS) and continued with resume must follow the same trajectory as an uninterrupted search with the same seed
+void testInterruptedSearch(const std::string & instancePath, bool isRoundingInteger, int maxMovesLS, double timeLimitLS)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	ap.maxMovesLS = maxMovesLS;
+	ap.timeLimitLS = timeLimitLS;
+	Params paramsInterrupted = makeParams(cvrp, ap);
+	Split split(params);
+	Split splitInterrupted(paramsInterrupted);
+	LocalSearch localSearch(params);
+	LocalSearch localSearchInterrupted(paramsInterrupted);
+	std::string context = "Interrupted search on " + instancePath;
+	for (int i = 0; i < 10; i++)
+	{
+		Individual indiv(params);
+		Individual indivInterrupted(paramsInterrupted);
+		split.generalSplit(indiv, params.nbVehicles);
+		splitInterrupted.generalSplit(indivInterrupted, paramsInterrupted.nbVehicles);
+		check(localSearch.run(indiv, 0.1 * params.penaltyCapacity, 0.1 * params.penaltyDuration), context + ": search without budget interrupted");
+		Individual indivBeforeSearch = indivInterrupted;
+		if (!localSearchInterrupted.run(indivInterrupted, 0.1 * paramsInterrupted.penaltyCapacity, 0.1 * paramsInterrupted.penaltyDuration))
+		{
+			check(haveSameRoutes(indivInterrupted, indivBeforeSearch), context + ": interrupted search modifies the individual");
+			check(localSearchInterrupted.resume(indivInterrupted), context + ": resumed search not completed");
+		}
+		checkSolution(paramsInterrupted, indivInterrupted, context);
+		check(haveSameRoutes(indivInterrupted, indiv), context + ": solution differs from the uninterrupted search");
+		if (indiv.eval.isFeasible) continue;
+
+		// The repair also continues from the resumed search
+		localSearch.repair(indiv, 10. * params.penaltyCapacity, 10. * params.penaltyDuration);
+		if (!localSearchInterrupted.repair(indivInterrupted, 10. * paramsInterrupted.penaltyCapacity, 10. * paramsInterrupted.penaltyDuration))
+			localSearchInterrupted.resume(indivInterrupted);
+		checkSolution(paramsInterrupted, indivInterrupted, context + " (repair)");
+		check(haveSameRoutes(indivInterrupted, indiv), context + ": repaired solution differs from the uninterrupted search");
+	}
+	check(localSearchInterrupted.nbCalls == 10, context + ": " + std::to_string(localSearchInterrupted.nbCalls) + " calls to run counted instead of 10");
+	check(localSearchInterrupted.nbInterruptions > 0 && localSearchInterrupted.nbInterruptions <= localSearchInterrupted.nbCalls, context + ": inconsistent number of interruptions");
+}
+
+// The index of circle sectors must enumerate exactly the indexed sectors overlapping a given one (as found by testing all of them), while sectors are inserted, moved, resized and removed, including sectors crossing the angle 0
+void testCircleSectorIndex()
+{
+	std::minstd_rand ran(1);
+	int nbElements = 50;
+	CircleSectorIndex sectorIndex;
+	sectorIndex.initialize(nbElements);
+	std::vector <bool> isIndexed(nbElements, false);
+	std::vector <int> overlapping;
+	for (int k = 0; k < 20000; k++)
+	{
+		int element = ran() % nbElements;
+		if (ran() % 4 == 0)
+		{
+			sectorIndex.remove(element);
+			isIndexed[element] = false;
+		}
+		else
+		{
+			// Mostly small changes of the previous sector, as in the local search, and some arbitrary new sectors
+			CircleSector sector;
+			if (isIndexed[element] && ran() % 2 == 0) sector.initialize(CircleSector::positive_mod(sectorIndex.sectors[element].start + (int)(ran() % 2001) - 1000));
+			else sector.initialize(ran() % 65536);
+			int maxLength = 1 + ran() % 30000;
+			sector.extend(CircleSector::positive_mod(sector.start + (int)(ran() % maxLength)));
+			sectorIndex.update(element, sector);
+			isIndexed[element] = true;
+		}
+		if (k % 100 == 0) sectorIndex.refreshMaxLength();
+
+		CircleSector query;
+		query.initialize(ran() % 65536);
+		query.extend(CircleSector::positive_mod(query.start + (int)(ran() % 20000)));
+		sectorIndex.getOverlaps(query, overlapping);
+		std::vector <int> reference;
+		for (int e = 0; e < nbElements; e++)
+			if (isIndexed[e] && CircleSector::overlap(query, sectorIndex.sectors[e])) reference.push_back(e);
+		std::sort(overlapping.begin(), overlapping.end());
+		if (overlapping != reference)
+		{
+			check(false, "Index of circle sectors: " + std::to_string(overlapping.size()) + " overlapping sectors found instead of " + std::to_string(reference.size()) + " after " + std::to_string(k + 1) + " updates");
+			return;
+		}
+	}
+}
+
+// Checks the data updated incrementally by the local search against a complete recalculation
+void checkIncrementalData(LocalSearch & localSearch, const std::string & context)
+{
+	try
+	{
+		localSearch.checkRouteData();
+		localSearch.checkInsertionMemory();
+	}
+	catch (const std::string & error) { check(false, context + ": " + error); }
+}
+
+// The data updated incrementally by the moves must remain identical to a complete recalculation at any point of the search: the searches are interrupted after random numbers of moves to check it, and checked again once completed and repaired
+// With isAsymmetric, random amounts are added to the distances, so that the reversal distances shifted on the unchanged tail of the routes are not all zero
+void testIncrementalData(const std::string & instancePath, bool isRoundingInteger, bool isAsymmetric)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	std::minstd_rand ran(1);
+	if (isAsymmetric)
+		for (int i = 0; i < (int)cvrp.dist_mtx.size(); i++)
+			for (int j = 0; j < (int)cvrp.dist_mtx.size(); j++)
+				if (i != j) cvrp.dist_mtx[i][j] += (double)(ran() % 20);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	Split split(params);
+	LocalSearch localSearch(params);
+	std::string context = "Incremental data on " + instancePath + (isAsymmetric ? " (asymmetric)" : "");
+	for (int i = 0; i < 20; i++)
+	{
+		Individual indiv(params);
+		split.generalSplit(indiv, params.nbVehicles);
+		params.ap.maxMovesLS = 1 + params.ran() % 200;
+		if (!localSearch.run(indiv, 0.1 * params.penaltyCapacity, 0.1 * params.penaltyDuration))
+		{
+			checkIncrementalData(localSearch, context + " (interrupted search)");
+			localSearch.resume(indiv);
+		}
+		checkIncrementalData(localSearch, context);
+		if (indiv.eval.isFeasible) continue;
+		if (!localSearch.repair(indiv, 10. * params.penaltyCapacity, 10. * params.penaltyDuration))
+		{
+			checkIncrementalData(localSearch, context + " (interrupted repair)");
+			localSearch.resume(indiv);
+		}
+		checkIncrementalData(localSearch, context + " (repair)");
+	}
+}
+
+// Checks that the genetic algorithm found a valid best solution respecting the capacity and duration constraints
+void checkBestSolution(const Params & params, Genetic & solver, const std::string & context)
+{
+	const Individual * bestSolution = solver.population.getBestFound();
+	check(bestSolution != NULL, context + ": no feasible solution found");
+	if (bestSolution == NULL) return;
+	checkSolution(params, *bestSolution, context);
+	check(bestSolution->eval.isFeasible, context + ": infeasible best solution");
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		double load = 0.;
+		double duration = 0.;
+		int previousClient = 0;
+		for (int client : bestSolution->route(r))
+		{
+			load += params.cli[client].demand;
+			duration += params.timeCost[previousClient][client] + params.cli[client].serviceDuration;
+			previousClient = client;
+		}
+		duration += params.timeCost[previousClient][0];
+		check(load < params.vehicleCapacity + MY_EPSILON, context + ": route exceeding the vehicle capacity");
+		check(!params.isDurationConstraint || duration < params.durationLimit + MY_EPSILON, context + ": route exceeding the duration limit");
+	}
+}
+
+// With several threads, the local search first improves groups of routes in parallel: it must still return valid local minima, and the genetic algorithm feasible solutions
+void testParallelSearch(const std::string & instancePath, bool isRoundingInteger, int nbThreadsLS)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	ap.nbThreadsLS = nbThreadsLS;
+	ap.nbIter = 1000;
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Search with " + std::to_string(nbThreadsLS) + " threads on " + instancePath;
+	{
+		Split split(params);
+		LocalSearch localSearch(params);
+		for (int i = 0; i < 10; i++)
+		{
+			Individual indiv(params);
+			split.generalSplit(indiv, params.nbVehicles);
+			double costBeforeSearch = indiv.eval.penalizedCost;
+			check(localSearch.run(indiv, params.penaltyCapacity, params.penaltyDuration), context + ": search interrupted without budget");
+			checkSolution(params, indiv, context);
+			check(indiv.eval.penalizedCost < costBeforeSearch + MY_EPSILON, context + ": the search deteriorates the solution");
+		}
+	}
+
+	Genetic solver(params);
+	solver.run();
+	checkBestSolution(params, solver, context + " (genetic algorithm)");
+}
+
+// Decomposition phases solve subproblems with their own genetic algorithm: the merged solutions must remain valid and feasible
+void testDecomposition(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	ap.nbIter = 1000;
+	ap.nbIterDecomposition = 300;
+	ap.sizeDecomposition = 30;
+	ap.timeLimitDecomposition = 0.2;
+	Params params = makeParams(cvrp, ap);
+	Genetic solver(params);
+	solver.run();
+	double bestCost = solver.population.getBestFound()->eval.penalizedCost;
+	solver.decompose();
+	checkBestSolution(params, solver, "Decomposition on " + instancePath);
+	check(solver.population.getBestFound()->eval.penalizedCost < bestCost + MY_EPSILON, "Decomposition on " + instancePath + " deteriorates the best solution");
+}
+
+// A subproblem which cannot be solved must not terminate the program from its thread: here, the customers of one half of the instance have very small demands, and the subproblem made of their routes is rejected by the safeguards of Params
+void testDecompositionFailure()
+{
+	std::vector <double> x_coords(1, 0.);
+	std::vector <double> y_coords(1, 0.);
+	std::vector <double> service_time(1, 0.);
+	std::vector <double> demands(1, 0.);
+	std::minstd_rand ran(1);
+	for (int i = 0; i < 60; i++)
+	{
+		bool isSmallDemand = (i < 30); // The small demands are located at a polar angle of about 0, the other ones at about pi/2
+		x_coords.push_back((isSmallDemand ? 100. : 0.) + (double)(ran() % 1000) / 100.);
+		y_coords.push_back((isSmallDemand ? 0. : 100.) + (double)(ran() % 1000) / 100.);
+		service_time.push_back(0.);
+		demands.push_back(isSmallDemand ? 0.05 : 10.);
+	}
+	std::vector < std::vector <double> > dist_mtx(x_coords.size(), std::vector <double>(x_coords.size()));
+	for (int i = 0; i < (int)x_coords.size(); i++)
+		for (int j = 0; j < (int)x_coords.size(); j++)
+			dist_mtx[i][j] = std::sqrt((x_coords[i] - x_coords[j]) * (x_coords[i] - x_coords[j]) + (y_coords[i] - y_coords[j]) * (y_coords[i] - y_coords[j]));
+	AlgorithmParameters ap = testParameters();
+	ap.nbIter = 500;
+	ap.sizeDecomposition = 20;
+	ap.timeLimitDecomposition = 0.1;
+	Params params(x_coords, y_coords, dist_mtx, service_time, demands, 100., 1.e30, INT_MAX, false, false, ap);
+	Genetic solver(params);
+	solver.run();
+	double bestCost = solver.population.getBestFound()->eval.penalizedCost;
+	solver.decompose();
+	checkBestSolution(params, solver, "Decomposition with a rejected subproblem");
+	check(solver.population.getBestFound()->eval.penalizedCost < bestCost + MY_EPSILON, "Decomposition with a rejected subproblem deteriorates the best solution");
+}
+
+// The multilevel mode solves coarser instances made of pairs of customers: the refined solution must be valid and feasible for the original instance
+void testMultilevel(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	ap.nbIter = 500;
+	ap.nbCoarseningLevels = 2;
+	Params params = makeParams(cvrp, ap);
+	Genetic solver(params);
+	solver.run();
+	checkBestSolution(params, solver, "Multilevel mode on " + instancePath);
+}
+
+// The evaluations obtained from the cache of route evaluations must be identical to the ones calculated without cache, including after replacements in a small cache
+void testRouteCache(const std::string & instancePath, bool isRoundingInteger, int routeCacheSize)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	ap.routeCacheSize = routeCacheSize;
+	Params paramsCache = makeParams(cvrp, ap);
+	std::string context = "Route cache of size " + std::to_string(routeCacheSize) + " on " + instancePath;
+	Split split(params);
+	LocalSearch localSearch(params);
+	for (int i = 0; i < 20; i++)
+	{
+		Individual indiv(params);
+		split.generalSplit(indiv, params.nbVehicles);
+		localSearch.run(indiv, params.penaltyCapacity, params.penaltyDuration);
+		for (int nbEvaluations = 0; nbEvaluations < 2; nbEvaluations++) // Unless the cache is too small, the second evaluation finds the routes in the cache
+		{
+			Individual evaluated = indiv;
+			evaluated.evaluateCompleteCost(paramsCache);
+			check(evaluated.eval.distance == indiv.eval.distance && evaluated.eval.capacityExcess == indiv.eval.capacityExcess
+				&& evaluated.eval.durationExcess == indiv.eval.durationExcess && evaluated.eval.nbRoutes == indiv.eval.nbRoutes, context + ": evaluation differs from the one without cache");
+		}
+	}
+	check((routeCacheSize == 1 || paramsCache.nbRouteCacheHits > 0) && paramsCache.nbRouteCacheHits <= paramsCache.nbRouteCacheLookups, context + ": inconsistent numbers of hits and lookups");
+	check(params.nbRouteCacheLookups == 0, context + ": lookups counted without cache");
+}
+
+// The statistics of the phases must be consistent with the run of the genetic algorithm: one crossover per iteration, one Split and one local search per individual, and phase times within the total time
+void testStatistics(const std::string & instancePath, bool isRoundingInteger, int nbThreadsLS)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	ap.nbIter = 2000;
+	ap.nbThreadsLS = nbThreadsLS;
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Statistics with " + std::to_string(nbThreadsLS) + " threads on " + instancePath;
+	Genetic solver(params);
+	solver.run();
+	Statistics stats = solver.population.getStatistics();
+	check(stats.nbIterations > 0 && stats.nbCrossovers <= stats.nbIterations, context + ": more crossovers than iterations");
+	check(stats.nbSplits == stats.nbLocalSearches && stats.nbSplitsLF <= stats.nbSplits, context + ": numbers of Split and local searches differ");
+	check(stats.nbLocalSearches >= stats.nbCrossovers && stats.nbRepairs <= stats.nbLocalSearches && stats.nbLoopsLS >= stats.nbLocalSearches, context + ": inconsistent numbers of local searches");
+	check(stats.nbInsertions >= stats.nbLocalSearches && stats.nbInsertions <= stats.nbLocalSearches + stats.nbRepairs, context + ": inconsistent number of insertions");
+	long long nbMoveSuccesses = 0;
+	for (int k = 0; k < NB_MOVE_TYPES; k++)
+	{
+		check(stats.nbMoveSuccesses[k] <= stats.nbMoveEvaluations[k], context + ": more successes than evaluations of move " + std::to_string(k));
+		nbMoveSuccesses += stats.nbMoveSuccesses[k];
+	}
+	check(nbMoveSuccesses > 0, context + ": no improving move counted");
+	double timePhases = stats.timeCrossover + stats.timeSplit + stats.timeLocalSearch + stats.timeRepair + stats.timePopulation + stats.timePenaltyUpdates;
+	check(stats.timeCrossover >= 0. && stats.timeSplit >= 0. && stats.timeLocalSearch > 0. && stats.timePopulation >= 0. && timePhases <= stats.time, context + ": inconsistent phase times");
+}
+
+// Each thread must record its phases in its own ring buffer, in the order of their ends, and keep only the last events once the buffer is full
+void testTrace(const std::string & instancePath, bool isRoundingInteger, int traceSize)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	ap.nbIter = 1000;
+	ap.nbThreadsLS = 2;
+	ap.traceSize = traceSize;
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Trace of size " + std::to_string(traceSize) + " on " + instancePath;
+	Genetic solver(params);
+	solver.run();
+	check(params.traceBuffers.size() == 2, context + ": one trace buffer per thread expected");
+	for (const TraceBuffer & traceBuffer : params.traceBuffers)
+	{
+		if (traceSize == 0) { check(traceBuffer.nbEvents == 0, context + ": events recorded by an inactive trace"); continue; }
+		check(traceBuffer.nbEvents > 0, context + ": no event recorded");
+		long long nbEventsKept = std::min<long long>(traceBuffer.nbEvents, traceSize);
+		double lastEndTime = params.startWallClock;
+		for (long long k = traceBuffer.nbEvents - nbEventsKept; k < traceBuffer.nbEvents; k++)
+		{
+			const TraceEvent & event = traceBuffer.events[k % traceSize];
+			check(event.startTime <= event.endTime && event.endTime >= lastEndTime, context + ": events not recorded in the order of their ends");
+			lastEndTime = event.endTime;
+		}
+	}
+	if (traceSize > 0)
+	{
+		const TraceBuffer & traceBuffer = params.traceBuffers[0];
+		check(std::string(traceBuffer.events[(traceBuffer.nbEvents - 1) % traceSize].name) == "iteration", context + ": the last event of the calling thread is not an iteration");
+	}
+}
+
+// Broken pairs distance with the original branching loop: proportion of the clients whose successor is not adjacent to them in indiv2, or starting a route in indiv1 but not adjacent to the depot in indiv2
+double referenceBrokenPairsDistance(const Params & params, const Individual & indiv1, const Individual & indiv2)
+{
+	int differences = 0;
+	for (int j = 1; j <= params.nbClients; j++)
+	{
+		if (indiv1.successors[j] != indiv2.successors[j] && indiv1.successors[j] != indiv2.predecessors[j]) differences++;
+		if (indiv1.predecessors[j] == 0 && indiv2.predecessors[j] != 0 && indiv2.successors[j] != 0) differences++;
+	}
+	return (double)differences / (double)params.nbClients;
+}
+
+// The branchless broken pairs distance must be equal to the one of the original loop, on pairs of random solutions, of local minima, and of a solution and its neighbors obtained by a single change
+void testBrokenPairsDistance(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Broken pairs distance on " + instancePath;
+	Genetic solver(params);
+	std::vector <Individual> solutions;
+	for (int i = 0; i < 20; i++)
+	{
+		Individual indiv(params);
+		solver.split.generalSplit(indiv, params.nbVehicles);
+		if (i % 2 == 1) solver.localSearch.run(indiv, params.penaltyCapacity, params.penaltyDuration);
+		solutions.push_back(indiv);
+
+		// Neighbor obtained by exchanging two positions of the giant tour, in the same route or not
+		Individual neighbor = indiv;
+		std::swap(neighbor.chromT[params.ran() % params.nbClients], neighbor.chromT[params.ran() % params.nbClients]);
+		neighbor.evaluateCompleteCost(params);
+		solutions.push_back(neighbor);
+	}
+	for (const Individual & indiv1 : solutions)
+		for (const Individual & indiv2 : solutions)
+			check(solver.population.brokenPairsDistance(indiv1, indiv2) == referenceBrokenPairsDistance(params, indiv1, indiv2), context + ": distance differs from the original loop");
+}
+
+// Routes of a solution as a sorted list of sequences, each route being oriented from its smallest extremity
+std::vector < std::vector <int> > normalizedRoutes(const Params & params, const Individual & indiv)
+{
+	std::vector < std::vector <int> > routes;
+	for (int r = 0; r < params.nbVehicles; r++)
+	{
+		RouteSequence route = indiv.route(r);
+		if (route.empty()) continue;
+		routes.push_back(std::vector <int>(route.begin(), route.end()));
+		if (route.front() > route.back()) std::reverse(routes.back().begin(), routes.back().end());
+	}
+	std::sort(routes.begin(), routes.end());
+	return routes;
+}
+
+// The solution hash must identify the solutions with the same routes, regardless of their order and orientation, and the giant tour hash the identical giant tours
+void testSolutionHash(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Solution hash on " + instancePath;
+	Split split(params);
+	LocalSearch localSearch(params);
+	std::vector <Individual> solutions;
+	for (int i = 0; i < 20; i++)
+	{
+		Individual indiv(params);
+		split.generalSplit(indiv, params.nbVehicles);
+		localSearch.run(indiv, params.penaltyCapacity, params.penaltyDuration);
+		solutions.push_back(indiv);
+
+		// Same routes in the reverse order, every second route being reversed
+		Individual transformed = indiv;
+		int pos = 0;
+		for (int k = 0; k < params.nbVehicles; k++)
+		{
+			RouteSequence route = indiv.route(params.nbVehicles - 1 - k);
+			transformed.routeStarts[k] = pos;
+			for (int j = 0; j < route.size(); j++) transformed.chromT[pos + j] = (k % 2 == 0) ? route[j] : route[route.size() - 1 - j];
+			pos += route.size();
+		}
+		transformed.evaluateCompleteCost(params);
+		solutions.push_back(transformed);
+
+		// Giant tour of the local minimum split again, which may give other routes
+		Individual resplit = indiv;
+		split.generalSplit(resplit, params.nbVehicles);
+		solutions.push_back(resplit);
+	}
+	for (const Individual & indiv1 : solutions)
+	{
+		for (const Individual & indiv2 : solutions)
+		{
+			check((indiv1.solutionHash == indiv2.solutionHash) == (normalizedRoutes(params, indiv1) == normalizedRoutes(params, indiv2)), context + ": solution hashes not matching the routes");
+			check((indiv1.hashGiantTour() == indiv2.hashGiantTour()) == (indiv1.chromT == indiv2.chromT), context + ": giant tour hashes not matching the giant tours");
+		}
+	}
+}
+
+// A solution exported in CVRPLib format must be read back with the same routes and cost
+void testSolutionFile(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Solution file on " + instancePath;
+	std::string fileName = "lib_test_cpp_solution.sol";
+	Genetic solver(params);
+	int nbSolutionsRead = 0;
+	for (int i = 0; i < 10; i++)
+	{
+		Individual indiv(params);
+		solver.split.generalSplit(indiv, params.nbVehicles);
+		solver.localSearch.run(indiv, params.penaltyCapacity, params.penaltyDuration);
+		if (!indiv.eval.isFeasible) solver.localSearch.repair(indiv, 100. * params.penaltyCapacity, 100. * params.penaltyDuration);
+		if (!indiv.eval.isFeasible) continue; // Only feasible solutions are accepted in input
+		solver.population.exportCVRPLibFormat(indiv, fileName);
+		Individual indivRead(params, fileName);
+		checkSolution(params, indivRead, context);
+		check(normalizedRoutes(params, indivRead) == normalizedRoutes(params, indiv) && indivRead.eval.penalizedCost == indiv.eval.penalizedCost, context + ": solution read differs from the one exported");
+		nbSolutionsRead++;
+	}
+	std::remove(fileName.c_str());
+	check(nbSolutionsRead > 0, context + ": no feasible solution to export");
+}
+
+// Same iteration as in Genetic::run (without the restarts and decompositions), returns true if a new best solution has been found
+bool runIteration(Params & params, Genetic & solver, int nbIter)
+{
+	bool isNewBest = false;
+	if (solver.crossoverOX(solver.offspring, solver.population.getBinaryTournament(), solver.population.getBinaryTournament()))
+	{
+		if (!solver.localSearch.run(solver.offspring, params.penaltyCapacity, params.penaltyDuration)) solver.localSearch.resume(solver.offspring);
+		isNewBest = solver.population.addIndividual(solver.offspring, true);
+		if (!solver.offspring.eval.isFeasible && params.ran() % 2 == 0)
+		{
+			if (!solver.localSearch.repair(solver.offspring, params.penaltyCapacity*10., params.penaltyDuration*10.)) solver.localSearch.resume(solver.offspring);
+			if (solver.offspring.eval.isFeasible) isNewBest = (solver.population.addIndividual(solver.offspring, false) || isNewBest);
+		}
+	}
+	if (nbIter % params.ap.nbIterPenaltyManagement == 0) solver.population.managePenalties();
+	return isNewBest;
+}
+
+// The data cached by the subpopulations must remain identical to a complete recalculation along the iterations, including after the survivor selections and the penalty updates
+void testSubpopulations(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	ap.nbIterPenaltyManagement = 20;
+	Params params = makeParams(cvrp, ap);
+	std::string context = "Subpopulations on " + instancePath;
+	Genetic solver(params);
+	solver.population.generatePopulation();
+	for (int nbIter = 0; nbIter < 1000; nbIter++)
+	{
+		runIteration(params, solver, nbIter);
+		if (nbIter % 10 != 0) continue;
+		try { solver.population.checkSubpopulations(); }
+		catch (const std::string & error)
+		{
+			check(false, context + " after " + std::to_string(nbIter + 1) + " iterations: " + error);
+			return;
+		}
+	}
+
+	// Penalty updates from random penalty values, which reorder the infeasible subpopulation much more than during the search
+	for (int i = 0; i < 50; i++)
+	{
+		params.penaltyCapacity = 0.1 * (double)(1 + params.ran() % 10000);
+		params.penaltyDuration = 0.1 * (double)(1 + params.ran() % 10000);
+		solver.population.managePenalties();
+		try { solver.population.checkSubpopulations(); }
+		catch (const std::string & error)
+		{
+			check(false, context + " after a penalty update: " + error);
+			return;
+		}
+	}
+}
+
+// The feasibility history must give the fraction of feasible individuals among the last ones added, as counted over a list of all the individuals added (the initial ones being considered feasible)
+void testFeasibilityHistory()
+{
+	std::minstd_rand ran(1);
+	for (int size : {1, 7, 100})
+	{
+		FeasibilityHistory history(size);
+		std::vector <bool> allIndividuals(size, true);
+		for (int i = 0; i < 1000; i++)
+		{
+			bool isFeasible = (ran() % (1 + i % 5) == 0); // Varying proportions of feasible individuals
+			history.add(isFeasible);
+			allIndividuals.push_back(isFeasible);
+			int nbFeasible = (int)std::count(allIndividuals.end() - size, allIndividuals.end(), true);
+			if (history.fractionFeasible() != (double)nbFeasible / (double)size)
+			{
+				check(false, "Feasibility history of size " + std::to_string(size) + ": incorrect fraction after " + std::to_string(i + 1) + " individuals");
+				break;
+			}
+		}
+	}
+}
+
+// Once the individuals of the pool and the temporary vectors have reached their size, the iterations of the genetic algorithm must not allocate memory
+void testAllocations(const std::string & instancePath, bool isRoundingInteger)
+{
+	InstanceCVRPLIB cvrp(instancePath, isRoundingInteger);
+	AlgorithmParameters ap = testParameters();
+	Params params = makeParams(cvrp, ap);
+	Genetic solver(params);
+	solver.population.generatePopulation();
+
+	// The first 2000 iterations are the warm-up
+	int nbIterationsAllocating = 0;
+	for (int nbIter = 0; nbIter < 3000; nbIter++)
+	{
+		long long nbAllocationsStart = nbAllocations;
+		bool isNewBest = runIteration(params, solver, nbIter);
+		if (nbIter >= 2000 && nbAllocations > nbAllocationsStart && !isNewBest) nbIterationsAllocating++; // A new best solution is appended to the search progress
+	}
+	check(nbIterationsAllocating == 0, "Allocations on " + instancePath + ": " + std::to_string(nbIterationsAllocating) + " iterations allocate memory after the warm-up");
+}
+
+int main(int argc, char * argv[])
+{
+	if (argc != 2)
+	{
+		std::cout << "Call with: lib_test_cpp instanceDirectory" << std::endl;
+		return 1;
+	}
+	std::string instanceDirectory = std::string(argv[1]) + "/";
+
+	std::cout << "-------- Split optimality -----" << std::endl;
+	testSplitOptimality(instanceDirectory + "X-n101-k25.vrp", true);
+	testSplitOptimality(instanceDirectory + "CMT6.vrp", false);
+	testSplitOptimality(instanceDirectory + "CMT7.vrp", false);
+	testSplitOptimality(instanceDirectory + "CMT13.vrp", false);
+
+	std::cout << "-------- Repair of infeasible solutions -----" << std::endl;
+	testRepair(instanceDirectory + "X-n101-k25.vrp", true);
+	testRepair(instanceDirectory + "CMT7.vrp", false);
+
+	std::cout << "-------- Interrupted and resumed searches -----" << std::endl;
+	testInterruptedSearch(instanceDirectory + "X-n101-k25.vrp", true, 20, 0.);
+	testInterruptedSearch(instanceDirectory + "CMT7.vrp", false, 20, 0.);
+	testInterruptedSearch(instanceDirectory + "X-n101-k25.vrp", true, 0, 1.e-6);
+
+	std::cout << "-------- Index of circle sectors -----" << std::endl;
+	testCircleSectorIndex();
+
+	std::cout << "-------- Incremental data of the local search -----" << std::endl;
+	testIncrementalData(instanceDirectory + "X-n101-k25.vrp", true, false);
+	testIncrementalData(instanceDirectory + "CMT7.vrp", false, false);
+	testIncrementalData(instanceDirectory + "X-n101-k25.vrp", true, true);
+
+	std::cout << "-------- Parallel search over groups of routes -----" << std::endl;
+	for (int nbThreadsLS : {1, 2, 4})
+	{
+		testParallelSearch(instanceDirectory + "X-n101-k25.vrp", true, nbThreadsLS);
+		testParallelSearch(instanceDirectory + "CMT7.vrp", false, nbThreadsLS);
+	}
+
+	std::cout << "-------- Decomposition phases -----" << std::endl;
+	testDecomposition(instanceDirectory + "X-n101-k25.vrp", true);
+	testDecomposition(instanceDirectory + "CMT7.vrp", false);
+	testDecompositionFailure();
+
+	std::cout << "-------- Multilevel mode -----" << std::endl;
+	testMultilevel(instanceDirectory + "X-n101-k25.vrp", true);
+	testMultilevel(instanceDirectory + "CMT7.vrp", false);
+
+	std::cout << "-------- Cache of route evaluations -----" << std::endl;
+	for (int routeCacheSize : {1, 4096})
+	{
+		testRouteCache(instanceDirectory + "X-n101-k25.vrp", true, routeCacheSize);
+		testRouteCache(instanceDirectory + "CMT7.vrp", false, routeCacheSize);
+	}
+
+	std::cout << "-------- Statistics of the phases -----" << std::endl;
+	for (int nbThreadsLS : {1, 2})
+	{
+		testStatistics(instanceDirectory + "X-n101-k25.vrp", true, nbThreadsLS);
+		testStatistics(instanceDirectory + "CMT7.vrp", false, nbThreadsLS);
+	}
+
+	std::cout << "-------- Trace of the phases -----" << std::endl;
+	for (int traceSize : {0, 100, 1000000})
+	{
+		testTrace(instanceDirectory + "X-n101-k25.vrp", true, traceSize);
+		testTrace(instanceDirectory + "CMT7.vrp", false, traceSize);
+	}
+
+	std::cout << "-------- Broken pairs distance -----" << std::endl;
+	testBrokenPairsDistance(instanceDirectory + "X-n101-k25.vrp", true);
+	testBrokenPairsDistance(instanceDirectory + "CMT7.vrp", false);
+
+	std::cout << "-------- Solution hash -----" << std::endl;
+	testSolutionHash(instanceDirectory + "X-n101-k25.vrp", true);
+	testSolutionHash(instanceDirectory + "CMT7.vrp", false);
+
+	std::cout << "-------- Solution files -----" << std::endl;
+	testSolutionFile(instanceDirectory + "X-n101-k25.vrp", true);
+
+	std::cout << "-------- Data of the subpopulations -----" << std::endl;
+	testSubpopulations(instanceDirectory + "X-n101-k25.vrp", true);
+	testSubpopulations(instanceDirectory + "CMT7.vrp", false);
+
+	std::cout << "-------- Feasibility history -----" << std::endl;
+	testFeasibilityHistory();
+
+	std::cout << "-------- Allocations of the genetic algorithm -----" << std::endl;
+	testAllocations(instanceDirectory + "X-n101-k25.vrp", true);
+	testAllocations(instanceDirectory + "CMT7.vrp", false);
+
+	std::cout << (nbFailures == 0 ? "ALL TESTS PASSED" : "SOME TESTS FAILED") << std::endl;
+	return (nbFailures == 0) ? 0 : 1;
+}